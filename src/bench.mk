@@ -0,0 +1,48 @@
+CXX 			:= 		clang++
+
+CFLAGS			:=		-std=c++11 -O2 -DNDEBUG -Wall -Werror -Wextra
+CFLAGS 			+= 		$(shell pkg-config --cflags benchmark glm glew glfw3)
+LDFLAGS 		:= 		$(shell pkg-config --libs benchmark glm glew glfw3) -pthread
+
+TARGET			:= 		bench
+# Machine readable results, see --benchmark_out_format
+RESULTS			:=		bench_results.json
+# Largest input, the 50M triangle files need several GB of disk and memory
+MAX_TRIANGLES	:=		50000000
+BENCH_ARGS		:=
+
+MODULES			:= 		$(shell find . -type d | grep -E "utils|loader")
+BENCH_MODULES	:= 		$(shell find . -type d | grep -E "benchmarks")
+
+SRC				:= 		$(notdir $(shell find $(MODULES) -maxdepth 1 -name "*.cpp"))
+INC				:=		$(shell find $(MODULES) $(BENCH_MODULES) -maxdepth 1 -name "*.hpp")
+BENCH_SRC		:= 		$(notdir $(shell find $(BENCH_MODULES) -maxdepth 1 -name "*.cpp"))
+OBJS			:=		$(SRC:%.cpp=%.o) $(BENCH_SRC:%.cpp=%.o)
+OBJS_DIR		:= 		./bench_objs
+
+vpath %.cpp 	$(MODULES) : $(BENCH_MODULES)
+vpath %.o 	$(OBJS_DIR)
+
+all				: $(TARGET)
+					./$(TARGET) --max_triangles=$(MAX_TRIANGLES) --benchmark_out=$(RESULTS) --benchmark_out_format=json $(BENCH_ARGS)
+
+$(TARGET)		: $(OBJS)
+					$(CXX) -o $@ $(addprefix $(OBJS_DIR)/, $(OBJS)) $(LDFLAGS)
+
+%.o 			: %.cpp $(INC) $(OBJS_DIR)
+					$(CXX) $(CFLAGS) -o $(addprefix $(OBJS_DIR)/, $@) -c $<
+$(OBJS_DIR) 	:
+				mkdir -p $(OBJS_DIR)
+
+clean			:
+					rm -rf $(OBJS_DIR)
+					rm -rf $(TARGET)
+					rm -rf $(RESULTS)
+
+# Generated inputs are kept between runs, this removes them too
+fclean			: clean
+					rm -rf bench_data
+
+re: clean $(TARGET)
+
+.PHONY: all clean fclean re
@@ -0,0 +1,185 @@
+#include "bench_inputs.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <sys/stat.h>
+
+// Most faces of a grid whose vertices keep .model indices within 16 bits
+constexpr int64_t MODEL_GRID_TRIANGLES = 2 * 255 * 255;
+
+static void grid_size(int64_t triangles, int64_t &columns, int64_t &rows);
+static bool file_exists(std::string const &path);
+static bool make_bench_data_dir();
+static uint16_t float_to_half(float value);
+
+std::vector<int64_t> bench_triangle_counts(int64_t max_triangles) {
+    int64_t const counts[] = {1000, 10000, 100000, 1000000, 10000000, 50000000};
+    std::vector<int64_t> sizes;
+    for (int64_t const count : counts) {
+        if (count <= max_triangles) {
+            sizes.push_back(count);
+        }
+    }
+    return sizes;
+}
+
+void make_bench_grid(int64_t triangles, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices) {
+    int64_t columns = 0, rows = 0;
+    grid_size(triangles, columns, rows);
+    positions.resize(static_cast<size_t>(columns * rows));
+    for (int64_t row = 0; row < rows; row++) {
+        for (int64_t column = 0; column < columns; column++) {
+            float const x = 2.0f * column / (columns - 1) - 1.0f;
+            float const z = 2.0f * row / (rows - 1) - 1.0f;
+            positions[row * columns + column] = glm::vec3(x, 0.1f * std::sin(7.0f * x) * std::cos(5.0f * z), z);
+        }
+    }
+
+    // Row by row, two counter-clockwise triangles per quad facing +y, stopping at the exact count
+    indices.clear();
+    indices.reserve(static_cast<size_t>(triangles) * 3);
+    for (int64_t quad = 0; static_cast<int64_t>(indices.size()) < triangles * 3; quad++) {
+        uint32_t const a = static_cast<uint32_t>(quad / (columns - 1) * columns + quad % (columns - 1));
+        uint32_t const b = a + 1, c = a + static_cast<uint32_t>(columns), d = c + 1;
+        uint32_t const quad_indices[6] = {a, c, b, b, c, d};
+        size_t const count = std::min<size_t>(6, static_cast<size_t>(triangles * 3) - indices.size());
+        indices.insert(indices.end(), quad_indices, quad_indices + count);
+    }
+}
+
+std::string bench_obj_path(int64_t triangles) {
+    std::string const path = std::string(BENCH_DATA_DIR) + "/grid_" + std::to_string(triangles) + ".obj";
+    if (file_exists(path)) {
+        return path;
+    }
+    if (!make_bench_data_dir()) {
+        return "";
+    }
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    make_bench_grid(triangles, positions, indices);
+
+    // Written under a temporary name so an interrupted run is not mistaken for a finished file
+    std::string const partial = path + ".partial";
+    FILE *file = fopen(partial.c_str(), "w");
+    if (!file) {
+        printf("Can't write benchmark input %s\n", path.c_str());
+        return "";
+    }
+    fprintf(file, "# %lld triangle benchmark grid\n", static_cast<long long>(triangles));
+    for (auto const &position : positions) {
+        fprintf(file, "v %.6f %.6f %.6f\n", position.x, position.y, position.z);
+    }
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        fprintf(file, "f %u %u %u\n", indices[i] + 1, indices[i + 1] + 1, indices[i + 2] + 1);
+    }
+    bool const ok = ferror(file) == 0;
+    fclose(file);
+    if (!ok || rename(partial.c_str(), path.c_str()) != 0) {
+        remove(partial.c_str());
+        return "";
+    }
+    return path;
+}
+
+std::string bench_model_path(int64_t triangles) {
+    // The loader picks the vertex layout from the LOD tag in the name
+    std::string const path = std::string(BENCH_DATA_DIR) + "/grid_" + std::to_string(triangles) + "_LOD3.model";
+    if (file_exists(path)) {
+        return path;
+    }
+    if (!make_bench_data_dir()) {
+        return "";
+    }
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> grid;
+    make_bench_grid(std::min(triangles, MODEL_GRID_TRIANGLES), positions, grid);
+
+    // The index block must open with the FIRST_FACE marker (0, 1, 2, 1): a
+    // degenerate face on the first row followed by the second face of the
+    // first quad. The grid faces then repeat until the count is reached.
+    std::vector<uint16_t> indices = {0, 1, 2};
+    for (size_t i = 3; static_cast<int64_t>(indices.size()) < triangles * 3; i = (i + 1) % grid.size()) {
+        indices.push_back(static_cast<uint16_t>(grid[i]));
+    }
+    // Faces are stored with the opposite winding, rotating the second one
+    // keeps its winding and puts its first index in place for the marker
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::swap(indices[i], indices[i + 2]);
+    }
+    std::swap(indices[0], indices[2]);
+    std::rotate(indices.begin() + 3, indices.begin() + 5, indices.begin() + 6);
+
+    std::string const partial = path + ".partial";
+    FILE *file = fopen(partial.c_str(), "wb");
+    if (!file) {
+        printf("Can't write benchmark input %s\n", path.c_str());
+        return "";
+    }
+    uint32_t const header[2] = {5, 0};
+    fwrite(header, sizeof(header), 1, file);
+    // LOD3 vertices: position, normal and two binormals as halves
+    for (auto const &position : positions) {
+        uint16_t const vertex[12] = {float_to_half(position.x), float_to_half(position.y), float_to_half(position.z),
+                                     0x0000, 0x3C00, 0x0000, 0x3C00, 0x0000, 0x0000, 0x0000, 0x0000, 0x3C00};
+        fwrite(vertex, sizeof(vertex), 1, file);
+    }
+    uint8_t const padding[8] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    fwrite(padding, (8 - (8 + positions.size() * 24) % 8) % 8, 1, file);
+    fwrite(indices.data(), sizeof(uint16_t), indices.size(), file);
+    uint16_t const end_marker[4] = {0, 1, 2, 3};
+    fwrite(end_marker, sizeof(end_marker), 1, file);
+    bool const ok = ferror(file) == 0;
+    fclose(file);
+    if (!ok || rename(partial.c_str(), path.c_str()) != 0) {
+        remove(partial.c_str());
+        return "";
+    }
+    return path;
+}
+
+/**
+ * @brief Vertex columns and rows of a near square grid with enough quads
+ */
+static void grid_size(int64_t triangles, int64_t &columns, int64_t &rows) {
+    int64_t const quads = (triangles + 1) / 2;
+    columns = std::max<int64_t>(3, static_cast<int64_t>(std::ceil(std::sqrt(static_cast<double>(quads)))) + 1);
+    rows = std::max<int64_t>(2, (quads + columns - 2) / (columns - 1) + 1);
+}
+
+static bool file_exists(std::string const &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && info.st_size > 0;
+}
+
+static bool make_bench_data_dir() {
+    if (mkdir(BENCH_DATA_DIR, 0755) != 0 && errno != EEXIST) {
+        printf("Could not create directory: '%s'\n", BENCH_DATA_DIR);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Rounds to the nearest half, the grid stays well inside the normal range
+ */
+static uint16_t float_to_half(float value) {
+    // Tiny values would be denormals that could spell out the face markers
+    if (std::fabs(value) < 1e-4f) {
+        return 0;
+    }
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint32_t const sign = (bits >> 16) & 0x8000u;
+    int32_t const exponent = static_cast<int32_t>((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t const mantissa = bits & 0x7FFFFFu;
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    // Round to nearest even, a carry into the exponent is still correct
+    uint32_t const rest = mantissa & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
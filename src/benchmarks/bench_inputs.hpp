@@ -0,0 +1,59 @@
+#ifndef BENCH_INPUTS_H_
+#define BENCH_INPUTS_H_
+
+#include "../includes/common.h"
+
+// Generated files are kept here between runs, the large ones take a while to write
+constexpr char BENCH_DATA_DIR[] = "./bench_data";
+
+/**
+ * @brief Triangle counts the size dependent benchmarks run at
+ *
+ * @param max_triangles Largest count to include
+ * @return Returns 1K, 10K, 100K, 1M, 10M and 50M up to max_triangles
+ */
+std::vector<int64_t> bench_triangle_counts(int64_t max_triangles);
+
+/**
+ * @brief Regular height field with exactly the requested number of triangles
+ *
+ * @param triangles Number of triangles
+ * @param positions Output unique positions, all within [-1, 1]
+ * @param indices Output 3 indices per triangle
+ */
+void make_bench_grid(int64_t triangles, std::vector<glm::vec3> &positions, std::vector<uint32_t> &indices);
+
+/**
+ * @brief OBJ file holding make_bench_grid, written on first use
+ *
+ * @param triangles Number of triangles
+ * @return Returns the path, empty if it could not be written
+ */
+std::string bench_obj_path(int64_t triangles);
+
+/**
+ * @brief PureParts LOD3 .model file with the requested number of triangles, written on first use
+ *
+ * The format has 16 bit indices, so larger counts repeat the faces of a
+ * grid of at most 65536 vertices.
+ *
+ * @param triangles Number of triangles
+ * @return Returns the path, empty if it could not be written
+ */
+std::string bench_model_path(int64_t triangles);
+
+/**
+ * @brief Registers the load_obj, load_model and .model benchmarks
+ *
+ * @param sizes Triangle counts from bench_triangle_counts
+ */
+void register_loader_benchmarks(std::vector<int64_t> const &sizes);
+
+/**
+ * @brief Registers the half float, bounds, color and MVP benchmarks
+ *
+ * @param sizes Triangle counts from bench_triangle_counts
+ */
+void register_math_benchmarks(std::vector<int64_t> const &sizes);
+
+#endif  // BENCH_INPUTS_H_
@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+#include <sys/stat.h>
+#include "bench_inputs.hpp"
+#include "../loader/loader.hpp"
+#include "../loader/pure_model.hpp"
+
+static int64_t file_size(std::string const &path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_size) : 0;
+}
+
+// Bytes and triangles per second, from the input file and the size argument
+static void set_file_throughput(benchmark::State &state, std::string const &path) {
+    state.SetBytesProcessed(state.iterations() * file_size(path));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["triangles"] = static_cast<double>(state.range(0));
+}
+
+static void BM_load_obj(benchmark::State &state) {
+    std::string const path = bench_obj_path(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        std::vector<glm::vec3> vertices;
+        size_t faces_count = 0, vertices_count = 0;
+        load_obj(path.c_str(), vertices, faces_count, vertices_count);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    set_file_throughput(state, path);
+}
+
+static void BM_load_obj_parallel(benchmark::State &state) {
+    std::string const path = bench_obj_path(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        std::vector<glm::vec3> vertices;
+        size_t faces_count = 0, vertices_count = 0;
+        load_obj_parallel(path.c_str(), vertices, faces_count, vertices_count);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    set_file_throughput(state, path);
+}
+
+// The indexed path the viewer uses, edges and bounds included, without the cache
+static void BM_load_model_obj(benchmark::State &state) {
+    std::string const path = bench_obj_path(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        Mesh mesh;
+        load_model(path, mesh, LOAD_NO_CACHE);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    set_file_throughput(state, path);
+}
+
+static void BM_load_pure_model(benchmark::State &state) {
+    std::string const path = bench_model_path(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    bool const keep_half_positions = state.range(1) != 0;
+    for (auto _ : state) {
+        Mesh mesh;
+        load_pure_model(path, mesh, keep_half_positions);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    set_file_throughput(state, path);
+}
+
+static void BM_load_model_pure(benchmark::State &state) {
+    std::string const path = bench_model_path(state.range(0));
+    if (path.empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        Mesh mesh;
+        load_model(path, mesh, LOAD_NO_CACHE);
+        benchmark::DoNotOptimize(mesh.indices.data());
+    }
+    set_file_throughput(state, path);
+}
+
+void register_loader_benchmarks(std::vector<int64_t> const &sizes) {
+    for (int64_t const size : sizes) {
+        benchmark::RegisterBenchmark("load_obj", BM_load_obj)->Arg(size)->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark("load_obj_parallel", BM_load_obj_parallel)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark("load_model/obj", BM_load_model_obj)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark("load_pure_model", BM_load_pure_model)
+            ->ArgNames({"triangles", "half"})
+            ->Args({size, 0})
+            ->Args({size, 1})
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark("load_model/model", BM_load_model_pure)
+            ->Arg(size)
+            ->Unit(benchmark::kMillisecond)
+            ->UseRealTime();
+    }
+}
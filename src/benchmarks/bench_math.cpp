@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include "bench_inputs.hpp"
+#include "../loader/half_float.hpp"
+#include "../loader/loader.hpp"
+#include "../loader/mesh_bounds.hpp"
+#include "../utils/utils.hpp"
+
+// A grid has about one vertex per two triangles
+static size_t grid_vertex_count(int64_t triangles) {
+    return static_cast<size_t>(triangles / 2 + 1);
+}
+
+static void BM_convert_float16_to_float32(benchmark::State &state) {
+    size_t const count = grid_vertex_count(state.range(0)) * 3;
+    std::vector<uint16_t> halves(count);
+    for (size_t i = 0; i < count; i++) {
+        // Every finite half, skipping infinities and NaNs
+        halves[i] = static_cast<uint16_t>((i * 0x9E37u) % 0x7C00u) | static_cast<uint16_t>((i & 1u) << 15);
+    }
+    std::vector<float> floats(count);
+    for (auto _ : state) {
+        convert_float16_to_float32(halves.data(), floats.data(), count);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(count * sizeof(uint16_t)));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+
+static void BM_calculate_bounds(benchmark::State &state) {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    make_bench_grid(state.range(0), positions, indices);
+    std::vector<uint32_t>().swap(indices);
+    for (auto _ : state) {
+        MeshBounds bounds;
+        calculate_bounds(positions, bounds);
+        benchmark::DoNotOptimize(bounds);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(positions.size() * sizeof(glm::vec3)));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(positions.size()));
+    state.counters["vertices"] = static_cast<double>(positions.size());
+}
+
+static void BM_generate_random_colors(benchmark::State &state) {
+    // Writes 9 floats per unit of size, one RGB per vertex for a third of the vertices
+    size_t const size = grid_vertex_count(state.range(0)) / 3 + 1;
+    std::vector<GLfloat> colors(size * 9);
+    for (auto _ : state) {
+        generate_random_colors(colors.data(), size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(colors.size() * sizeof(GLfloat)));
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(colors.size() / 3));
+}
+
+static void BM_compute_mvp(benchmark::State &state) {
+    float fov = 45.0f;
+    glm::vec3 camera(3.0f, 2.0f, 1.0f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fov);
+        benchmark::DoNotOptimize(camera);
+        glm::mat4 mvp = compute_mvp(fov, camera, glm::vec3(0.0f), 0.1f, 100.0f);
+        benchmark::DoNotOptimize(mvp);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void register_math_benchmarks(std::vector<int64_t> const &sizes) {
+    for (int64_t const size : sizes) {
+        benchmark::RegisterBenchmark("convert_float16_to_float32", BM_convert_float16_to_float32)
+            ->Arg(size)
+            ->Unit(benchmark::kMicrosecond);
+        benchmark::RegisterBenchmark("calculate_bounds", BM_calculate_bounds)
+            ->Arg(size)
+            ->Unit(benchmark::kMicrosecond)
+            ->UseRealTime();
+        benchmark::RegisterBenchmark("generate_random_colors", BM_generate_random_colors)
+            ->Arg(size)
+            ->Unit(benchmark::kMicrosecond);
+    }
+    benchmark::RegisterBenchmark("compute_mvp", BM_compute_mvp);
+}
@@ -0,0 +1,28 @@
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include "bench_inputs.hpp"
+
+int main(int argc, char **argv) {
+    // --max_triangles=N drops the larger sizes, the 50M inputs need several GB
+    int64_t max_triangles = 50000000;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--max_triangles=", 16) == 0) {
+            max_triangles = atoll(argv[i] + 16);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    std::vector<int64_t> const sizes = bench_triangle_counts(max_triangles);
+    register_loader_benchmarks(sizes);
+    register_math_benchmarks(sizes);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -17,4 +17,10 @@
 const unsigned int SCREEN_WIDTH = 1280;
 const unsigned int SCREEN_HEIGHT = 720;
 
+// Procedural coloring done by the shaders (see fshader.glsl) and the software rasterizer
+enum ColorMode {
+    COLOR_BY_VERTEX = 0,
+    COLOR_BY_FACE = 1,
+};
+
 #endif  // COMMON_H_
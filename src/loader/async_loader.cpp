@@ -0,0 +1,119 @@
+#include "async_loader.hpp"
+
+#include "../utils/utils.hpp"
+
+static void async_loader_main(AsyncModelLoader *loader);
+
+void start_async_loader(AsyncModelLoader &loader) {
+    loader.stopping = false;
+    loader.worker = std::thread(async_loader_main, &loader);
+}
+
+void stop_async_loader(AsyncModelLoader &loader) {
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.stopping = true;
+        loader.requests.clear();
+        loader.control.cancelled = true;
+    }
+    loader.wake.notify_all();
+    loader.finished.notify_all();
+    if (loader.worker.joinable()) {
+        loader.worker.join();
+    }
+}
+
+void request_model_load(AsyncModelLoader &loader, std::string const &path, unsigned flags) {
+    ModelLoadRequest request;
+    request.path = path;
+    request.flags = flags;
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.requests.push_back(request);
+    }
+    loader.wake.notify_one();
+}
+
+void cancel_model_loads(AsyncModelLoader &loader) {
+    std::lock_guard<std::mutex> lock(loader.mutex);
+    loader.requests.clear();
+    if (loader.busy) {
+        loader.control.cancelled = true;
+    }
+}
+
+bool poll_model_load(AsyncModelLoader &loader, ModelLoadResult &result) {
+    std::lock_guard<std::mutex> lock(loader.mutex);
+    if (loader.results.empty()) {
+        return false;
+    }
+    result = std::move(loader.results.front());
+    loader.results.pop_front();
+    return true;
+}
+
+bool wait_model_load(AsyncModelLoader &loader, ModelLoadResult &result) {
+    std::unique_lock<std::mutex> lock(loader.mutex);
+    loader.finished.wait(lock, [&loader] {
+        return !loader.results.empty() || (!loader.busy && loader.requests.empty()) || loader.stopping;
+    });
+    if (loader.results.empty()) {
+        return false;
+    }
+    result = std::move(loader.results.front());
+    loader.results.pop_front();
+    return true;
+}
+
+bool model_load_in_progress(AsyncModelLoader &loader, std::string &path, float &progress) {
+    std::lock_guard<std::mutex> lock(loader.mutex);
+    if (loader.busy) {
+        path = loader.loading_path;
+        progress = loader.control.progress;
+        return true;
+    }
+    if (!loader.requests.empty()) {
+        path = loader.requests.front().path;
+        progress = 0.0f;
+        return true;
+    }
+    return false;
+}
+
+static void async_loader_main(AsyncModelLoader *loader) {
+    std::unique_lock<std::mutex> lock(loader->mutex);
+    while (true) {
+        loader->wake.wait(lock, [loader] { return loader->stopping || !loader->requests.empty(); });
+        if (loader->stopping) {
+            return;
+        }
+
+        ModelLoadRequest request = loader->requests.front();
+        loader->requests.pop_front();
+        loader->busy = true;
+        loader->loading_path = request.path;
+        loader->control.cancelled = false;
+        loader->control.progress = 0.0f;
+        lock.unlock();
+
+        ModelLoadResult result;
+        result.path = request.path;
+        if (get_file_extension(request.path) == "scene") {
+            load_scene(request.path, result.scene, request.flags, &loader->control, &result.stats);
+        } else {
+            load_model(request.path, result.mesh, request.flags, &loader->control, &result.stats);
+        }
+
+        lock.lock();
+        loader->busy = false;
+        loader->loading_path.clear();
+        // A cancelled load has nothing worth showing
+        if (!loader->control.cancelled) {
+            loader->results.push_back(std::move(result));
+        }
+        loader->finished.notify_all();
+        if (loader->on_finished != nullptr) {
+            loader->on_finished();
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef ASYNC_LOADER_H_
+#define ASYNC_LOADER_H_
+
+#include "../includes/common.h"
+#include "loader.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+struct ModelLoadRequest {
+    std::string path;
+    unsigned flags = 0;
+};
+
+struct ModelLoadResult {
+    std::string path;
+    // Set for single model files
+    Mesh mesh;
+    // Set for .scene files, mesh is left empty
+    Scene scene;
+    // Where the load time went, summed over every mesh of a scene
+    LoadStats stats;
+};
+
+/**
+ * @brief Loads models on a worker thread, one request at a time
+ *
+ * Requests are queued from the GL thread and finished meshes are queued back,
+ * so the caller can keep drawing the current model while the next one loads.
+ */
+struct AsyncModelLoader {
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Signalled whenever the worker finishes a request
+    std::condition_variable finished;
+    std::deque<ModelLoadRequest> requests;
+    std::deque<ModelLoadResult> results;
+    // Path of the model being loaded right now, empty when idle
+    std::string loading_path;
+    LoadControl control;
+    bool busy = false;
+    bool stopping = false;
+    // Called by the worker after every finished or cancelled request, with
+    // the mutex held, e.g. to wake an event loop. Set it before starting.
+    void (*on_finished)() = nullptr;
+};
+
+/**
+ * @brief Starts the worker thread
+ *
+ * @param loader Loader to start, must not be running already
+ */
+void start_async_loader(AsyncModelLoader &loader);
+
+/**
+ * @brief Cancels any pending work and joins the worker thread
+ *
+ * @param loader Loader previously started with start_async_loader
+ */
+void stop_async_loader(AsyncModelLoader &loader);
+
+/**
+ * @brief Queues a model to be loaded with load_model, or a scene with load_scene
+ *
+ * @param loader Running loader
+ * @param path Path to the file
+ * @param flags Bitmask of LoadFlags
+ */
+void request_model_load(AsyncModelLoader &loader, std::string const &path, unsigned flags = 0);
+
+/**
+ * @brief Drops queued requests and asks the current load to stop
+ *
+ * @param loader Running loader
+ */
+void cancel_model_loads(AsyncModelLoader &loader);
+
+/**
+ * @brief Takes the oldest finished mesh, if any
+ *
+ * @param loader Running loader
+ * @param result Output path and mesh, the mesh is empty if the load failed
+ * @return Returns true if a result was taken
+ */
+bool poll_model_load(AsyncModelLoader &loader, ModelLoadResult &result);
+
+/**
+ * @brief Takes the oldest finished mesh, waiting for it if needed
+ *
+ * @param loader Running loader
+ * @param result Output path and mesh, the mesh is empty if the load failed
+ * @return Returns false if nothing was queued or the load was cancelled
+ */
+bool wait_model_load(AsyncModelLoader &loader, ModelLoadResult &result);
+
+/**
+ * @brief Reports what the worker is doing
+ *
+ * @param loader Running loader
+ * @param path Output path of the model being loaded
+ * @param progress Output progress of the current load, 0 to 1
+ * @return Returns true while a request is queued or being loaded
+ */
+bool model_load_in_progress(AsyncModelLoader &loader, std::string &path, float &progress);
+
+#endif  // ASYNC_LOADER_H_
@@ -0,0 +1,166 @@
+#include "half_float.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HALF_FLOAT_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HALF_FLOAT_NEON 1
+#endif
+
+// Half exponent field once shifted into the float position
+constexpr uint32_t HALF_EXPONENT_MASK = 0x7C00u << 13;
+// Rebias from 15 to 127
+constexpr uint32_t EXPONENT_ADJUST = (127 - 15) << 23;
+constexpr uint32_t FLOAT_QUIET_BIT = 0x00400000u;
+
+float convert_float16_to_float32(uint16_t float16_value) {
+    // MSB -> LSB
+    // float16=1bit: sign, 5bit: exponent, 10bit: fraction
+    // float32=1bit: sign, 8bit: exponent, 23bit: fraction
+    uint32_t float32_value = (float16_value & 0x7FFFu) << 13;
+    uint32_t const exponent = float32_value & HALF_EXPONENT_MASK;
+    float32_value += EXPONENT_ADJUST;
+
+    if (exponent == HALF_EXPONENT_MASK) {
+        // Inf or NaN, NaNs are made quiet like the hardware does
+        float32_value += EXPONENT_ADJUST;
+        if ((float32_value & 0x007FFFFFu) != 0) {
+            float32_value |= FLOAT_QUIET_BIT;
+        }
+    } else if (exponent == 0) {
+        // Zero or denormal: 2**-14 * 0.fraction, computed exactly by giving
+        // the value an implicit one and subtracting 2**-14 back out
+        float32_value += 1u << 23;
+        float value, magic;
+        uint32_t const magic_bits = 113u << 23;
+        memcpy(&value, &float32_value, sizeof(value));
+        memcpy(&magic, &magic_bits, sizeof(magic));
+        value -= magic;
+        memcpy(&float32_value, &value, sizeof(value));
+    }
+
+    float32_value |= static_cast<uint32_t>(float16_value & 0x8000u) << 16;
+
+    float result;
+    memcpy(&result, &float32_value, sizeof(result));
+    return result;
+}
+
+#ifdef HALF_FLOAT_X86
+__attribute__((target("avx,f16c")))
+static size_t convert_float16_to_float32_f16c(uint16_t const *float16_values, float *float32_values, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i const halves = _mm_loadu_si128(reinterpret_cast<__m128i const *>(float16_values + i));
+        _mm256_storeu_ps(float32_values + i, _mm256_cvtph_ps(halves));
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static size_t convert_float16_to_float32_sse2(uint16_t const *float16_values, float *float32_values, size_t count) {
+    __m128i const exponent_mask = _mm_set1_epi32(HALF_EXPONENT_MASK);
+    __m128i const exponent_adjust = _mm_set1_epi32(EXPONENT_ADJUST);
+    __m128i const implicit_one = _mm_set1_epi32(1 << 23);
+    __m128 const denormal_magic = _mm_castsi128_ps(_mm_set1_epi32(113 << 23));
+    __m128i const fraction_mask = _mm_set1_epi32(0x007FFFFF);
+    __m128i const quiet_bit = _mm_set1_epi32(FLOAT_QUIET_BIT);
+    __m128i const zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i const halves = _mm_unpacklo_epi16(
+            _mm_loadl_epi64(reinterpret_cast<__m128i const *>(float16_values + i)), zero);
+        __m128i const sign = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x8000)), 16);
+        __m128i value = _mm_slli_epi32(_mm_and_si128(halves, _mm_set1_epi32(0x7FFF)), 13);
+        __m128i const exponent = _mm_and_si128(value, exponent_mask);
+        value = _mm_add_epi32(value, exponent_adjust);
+
+        __m128i const is_inf_nan = _mm_cmpeq_epi32(exponent, exponent_mask);
+        value = _mm_add_epi32(value, _mm_and_si128(is_inf_nan, exponent_adjust));
+        __m128i const has_fraction = _mm_andnot_si128(
+            _mm_cmpeq_epi32(_mm_and_si128(value, fraction_mask), zero), is_inf_nan);
+        value = _mm_or_si128(value, _mm_and_si128(has_fraction, quiet_bit));
+
+        __m128i const is_denormal = _mm_cmpeq_epi32(exponent, zero);
+        __m128i const denormal = _mm_castps_si128(
+            _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(value, implicit_one)), denormal_magic));
+        value = _mm_or_si128(_mm_and_si128(is_denormal, denormal), _mm_andnot_si128(is_denormal, value));
+
+        _mm_storeu_ps(float32_values + i, _mm_castsi128_ps(_mm_or_si128(value, sign)));
+    }
+    return i;
+}
+
+static bool has_f16c() {
+    static bool const supported = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return supported;
+}
+#endif
+
+#ifdef HALF_FLOAT_NEON
+static size_t convert_float16_to_float32_neon(uint16_t const *float16_values, float *float32_values, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float16x4_t const halves = vreinterpret_f16_u16(vld1_u16(float16_values + i));
+        vst1q_f32(float32_values + i, vcvt_f32_f16(halves));
+    }
+    return i;
+}
+#endif
+
+void convert_float16_to_float32(uint16_t const *float16_values, float *float32_values, size_t count) {
+    size_t converted = 0;
+#if defined(HALF_FLOAT_X86)
+    if (has_f16c()) {
+        converted = convert_float16_to_float32_f16c(float16_values, float32_values, count);
+    } else {
+        converted = convert_float16_to_float32_sse2(float16_values, float32_values, count);
+    }
+#elif defined(HALF_FLOAT_NEON)
+    converted = convert_float16_to_float32_neon(float16_values, float32_values, count);
+#endif
+
+    for (size_t i = converted; i < count; i++) {
+        float32_values[i] = convert_float16_to_float32(float16_values[i]);
+    }
+}
+
+uint16_t convert_float32_to_float16(float float32_value) {
+    uint32_t bits;
+    memcpy(&bits, &float32_value, sizeof(bits));
+    uint32_t const sign = (bits >> 16) & 0x8000u;
+    uint32_t const magnitude = bits & 0x7FFFFFFFu;
+
+    if (magnitude >= 0x7F800000u) {
+        // Inf or NaN, NaNs keep their top fraction bits and are made quiet
+        uint32_t const nan_bits = magnitude > 0x7F800000u ? 0x0200u | ((magnitude >> 13) & 0x03FFu) : 0u;
+        return static_cast<uint16_t>(sign | 0x7C00u | nan_bits);
+    }
+    if (magnitude >= 0x477FF000u) {
+        // 65520 and above round past the largest half
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (magnitude < 0x38800000u) {
+        // Below 2**-14 the result is denormal: adding 0.5 lines the half
+        // fraction up with the low float bits and rounds it in the FPU
+        float value, magic;
+        uint32_t const magic_bits = 126u << 23;
+        memcpy(&value, &magnitude, sizeof(value));
+        memcpy(&magic, &magic_bits, sizeof(magic));
+        value += magic;
+        uint32_t value_bits;
+        memcpy(&value_bits, &value, sizeof(value_bits));
+        return static_cast<uint16_t>(sign | (value_bits - magic_bits));
+    }
+    // Rebias from 127 to 15 and round the 13 dropped bits to nearest even
+    uint32_t const odd = (magnitude >> 13) & 1u;
+    uint32_t const rounded = magnitude + (static_cast<uint32_t>(15 - 127) << 23) + 0x0FFFu + odd;
+    return static_cast<uint16_t>(sign | (rounded >> 13));
+}
+
+#undef HALF_FLOAT_X86
+#undef HALF_FLOAT_NEON
@@ -0,0 +1,40 @@
+#ifndef HALF_FLOAT_H_
+#define HALF_FLOAT_H_
+
+#include "../includes/common.h"
+
+/**
+ * @brief Converts one IEEE 754 half precision value to single precision
+ *
+ * Denormals are converted exactly and NaNs come out quiet, matching the
+ * F16C/NEON conversion instructions bit for bit.
+ *
+ * @param float16_value Raw half precision bits
+ * @return Returns the single precision value
+ */
+float convert_float16_to_float32(uint16_t float16_value);
+
+/**
+ * @brief Converts an array of half precision values to single precision
+ *
+ * Uses F16C, SSE2 or NEON when available and the scalar conversion for the
+ * remainder, all of which give identical results.
+ *
+ * @param float16_values Raw half precision bits to convert
+ * @param float32_values Output array, at least count floats
+ * @param count Number of values to convert
+ */
+void convert_float16_to_float32(uint16_t const *float16_values, float *float32_values, size_t count);
+
+/**
+ * @brief Converts one single precision value to half precision
+ *
+ * Rounds to nearest even like F16C, values too large for a half become
+ * infinities and NaNs stay quiet NaNs.
+ *
+ * @param float32_value Value to convert
+ * @return Returns the raw half precision bits
+ */
+uint16_t convert_float32_to_float16(float float32_value);
+
+#endif  // HALF_FLOAT_H_
@@ -0,0 +1,38 @@
+#include "load_stats.hpp"
+
+static char const *const STAGE_NAMES[LOAD_STAGE_COUNT] = {
+    "Open/read", "Marker search", "Parse", "Half decode", "Index build", "Bounds", "Cache", "Post-process"};
+
+void add_load_bytes(LoadStats *stats, unsigned stage, uint64_t bytes) {
+    if (stats != nullptr && stage < LOAD_STAGE_COUNT) {
+        stats->stages[stage].bytes += bytes;
+    }
+}
+
+char const *load_stage_name(unsigned stage) {
+    return stage < LOAD_STAGE_COUNT ? STAGE_NAMES[stage] : "";
+}
+
+void print_load_stats(std::string const &path, LoadStats const &stats) {
+    printf("%s: %.2f ms", path.c_str(), stats.total_ms);
+    if (stats.cache_hits != 0) {
+        printf(" (%zu of %zu from the mesh cache)", stats.cache_hits, stats.files);
+    }
+    printf("\n");
+    for (unsigned stage = 0; stage < LOAD_STAGE_COUNT; stage++) {
+        LoadStageStats const &stage_stats = stats.stages[stage];
+        if (stage_stats.ms == 0.0 && stage_stats.bytes == 0) {
+            continue;
+        }
+        double const share = stats.total_ms > 0.0 ? 100.0 * stage_stats.ms / stats.total_ms : 0.0;
+        printf("  %-14s %10.3f ms %5.1f%%", load_stage_name(stage), stage_stats.ms, share);
+        if (stage_stats.bytes != 0) {
+            double const megabytes = stage_stats.bytes / (1024.0 * 1024.0);
+            printf(" %10.2f MB", megabytes);
+            if (stage_stats.ms > 0.0) {
+                printf(" %9.1f MB/s", megabytes * 1000.0 / stage_stats.ms);
+            }
+        }
+        printf("\n");
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef LOAD_STATS_H_
+#define LOAD_STATS_H_
+
+#include "../includes/common.h"
+
+#include <chrono>
+
+/**
+ * @brief Steps of a load, timed separately
+ */
+enum LoadStage : unsigned {
+    // Opening and mapping the file, mapped pages fault in during later stages
+    LOAD_STAGE_READ = 0,
+    // Scanning .model files for the index block markers
+    LOAD_STAGE_MARKER_SEARCH,
+    // Turning file bytes into positions and indices
+    LOAD_STAGE_PARSE,
+    // Half to float conversion of .model positions
+    LOAD_STAGE_HALF_DECODE,
+    // Merging parsed chunks and writing the final index buffer
+    LOAD_STAGE_INDEX_BUILD,
+    // calculate_bounds
+    LOAD_STAGE_BOUNDS,
+    // Reading or writing the mesh cache
+    LOAD_STAGE_CACHE,
+    // Optimizing, meshlets, LODs and edges
+    LOAD_STAGE_POSTPROCESS,
+    LOAD_STAGE_COUNT,
+};
+
+/**
+ * @brief Time and data volume of one stage
+ */
+struct LoadStageStats {
+    double ms = 0.0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Where the time of one or more loads went
+ *
+ * Loads add to the stats passed in, so a scene sums all of its meshes.
+ */
+struct LoadStats {
+    LoadStageStats stages[LOAD_STAGE_COUNT];
+    double total_ms = 0.0;
+    // Loads answered by the mesh cache
+    size_t cache_hits = 0;
+    size_t files = 0;
+};
+
+/**
+ * @brief Adds the time until it goes out of scope to one stage, if stats is set
+ */
+struct LoadStageTimer {
+    LoadStats *stats;
+    unsigned stage;
+    std::chrono::steady_clock::time_point start;
+
+    LoadStageTimer(LoadStats *stats, unsigned stage)
+        : stats(stats), stage(stage), start(std::chrono::steady_clock::now()) {}
+    ~LoadStageTimer() { next(stage); }
+
+    // Charges the time so far to the current stage and starts timing another
+    void next(unsigned next_stage) {
+        auto const now = std::chrono::steady_clock::now();
+        if (stats != nullptr) {
+            stats->stages[stage].ms += std::chrono::duration<double, std::milli>(now - start).count();
+        }
+        stage = next_stage;
+        start = now;
+    }
+};
+
+/**
+ * @brief Adds bytes handled by a stage, if stats is set
+ *
+ * @param stats Optional stats to update
+ * @param stage LoadStage
+ * @param bytes Bytes read or written by the stage
+ */
+void add_load_bytes(LoadStats *stats, unsigned stage, uint64_t bytes);
+
+/**
+ * @brief Short name of a stage
+ *
+ * @param stage LoadStage
+ */
+char const *load_stage_name(unsigned stage);
+
+/**
+ * @brief Prints a table of the stages with their share of the total and throughput
+ *
+ * @param path File the stats belong to
+ * @param stats Stats to print
+ */
+void print_load_stats(std::string const &path, LoadStats const &stats);
+
+#endif  // LOAD_STATS_H_
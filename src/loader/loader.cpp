@@ -1,425 +1,645 @@
 #include "loader.hpp"
 
 #include <algorithm>
+#include <cstring>
+#include <thread>
+#include "mapped_file.hpp"
+#include "mesh.hpp"
+#include "mesh_bounds.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_edges.hpp"
+#include "mesh_optimize.hpp"
+#include "mesh_simplify.hpp"
+#include "meshlet.hpp"
+#include "pure_model.hpp"
+#include "half_float.hpp"
+#include "../utils/parallel.hpp"
 #include "../utils/utils.hpp"
 
-#define READ_FILE(file, output_block, output_block_size, output_block_count, break_stmt) \
-({                                                                                       \
-if (feof(file) != 0) {                                                                   \
-    break_stmt;                                                                          \
-}                                                                                        \
-auto amount_read = fread(output_block, output_block_size, output_block_count, file);     \
-if (ferror(file) != 0) {                                                                 \
-    printf("There was an error reading file: '%s'\n", filename);                         \
-    fflush(stdin);                                                                       \
-    fclose(file);                                                                        \
-    return;                                                                              \
-}                                                                                        \
-amount_read;                                                                             \
-})
-
-#define SEEK_FILE(file, offset, position, break_stmt)            \
-({                                                               \
-if (fseek(file, offset, position) != 0) {                        \
-    printf("There was an error seeking file: '%s'\n", filename); \
-    fflush(stdin);                                               \
-    fclose(file);                                                \
-    return;                                                      \
-}                                                                \
-if (ferror(file) != 0) {                                         \
-    printf("There was an error reading file: '%s'\n", filename); \
-    fflush(stdin);                                               \
-    fclose(file);                                                \
-    return;                                                      \
-}                                                                \
-})
-
-static void load_obj(const char *filename, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count);
-
-static void load_pure_model(std::string const &path, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count);
-
-static void load_pure_model_lod1(const char *filename, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count);
-static void load_pure_model_lod3(const char *filename, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count);
-
-static void calculate_size_and_center(std::vector<glm::vec3> const &vertices, float &model_size, glm::vec3 &model_center);
-
-static float convert_float16_to_float32(short float16_value);
+// Records parsed from one newline-aligned slice of an OBJ file
+struct ObjChunk {
+    std::vector<glm::vec3> positions;
+    std::vector<size_t> indices;
+    size_t faces_count = 0;
+};
+
+// Shared by the chunk parsers to report how much of the file is done
+struct ObjParseProgress {
+    LoadControl *control;
+    std::atomic<size_t> bytes_parsed;
+    size_t total_bytes;
+};
+
+// Files smaller than this per core are not worth splitting further
+constexpr size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+// Records one thread formats before the batch is written
+constexpr size_t OBJ_WRITE_BATCH = 1 << 16;
+// Bytes a chunk parser gets through between progress/cancel checks
+constexpr size_t OBJ_PROGRESS_STEP = 1 << 20;
+// Share of the load progress bar taken by parsing
+constexpr float PARSE_PROGRESS = 0.8f;
+
+static void load_mesh_stages(std::string const &path, Mesh &mesh, unsigned flags, LoadControl *control,
+                             LoadStats *stats);
+static void load_obj_mesh(const char *filename, Mesh &mesh, LoadControl *control, LoadStats *stats);
+static bool parse_obj_file(const char *filename, unsigned thread_count, std::vector<ObjChunk> &chunks,
+                           LoadControl *control, LoadStats *stats);
+static void merge_obj_positions(std::vector<ObjChunk> &chunks, std::vector<glm::vec3> &positions,
+                                std::vector<size_t> &index_offsets);
+static void parse_obj_chunk(char const *begin, char const *end, ObjChunk &chunk, ObjParseProgress *progress);
+static bool report_obj_progress(ObjParseProgress *progress, size_t bytes);
+static void optimize_loaded_mesh(Mesh &mesh);
+static void build_loaded_lods(Mesh &mesh);
+static void extract_loaded_edges(Mesh &mesh);
+static bool load_cancelled(LoadControl const *control);
+static void set_load_progress(LoadControl *control, float progress);
+static bool expand_obj_indices(std::vector<size_t> const &indices, std::vector<glm::vec3> const &positions,
+                               glm::vec3 *output);
+
+static inline bool is_blank(char c);
+static inline bool is_digit(char c);
+static char const *skip_blanks(char const *cursor, char const *end);
+static char const *parse_float(char const *cursor, char const *end, float &value);
+static char const *parse_index(char const *cursor, char const *end, size_t &index);
+
+static void calculate_half_bounds(std::vector<glm::u16vec3> const &half_positions, std::vector<glm::vec3> &bounds);
+static void format_obj_records(Mesh const &mesh, size_t first, size_t last, std::string &text);
 
 void load_model(std::string const &path, std::vector<glm::vec3> &vertices,
                 size_t &faces_count, size_t &vertices_count, float &model_size, glm::vec3 &model_center)
 {
     auto file_ext = get_file_extension(path);
     if (file_ext == "obj") {
-        load_obj(path.c_str(), vertices, faces_count, vertices_count);
+        load_obj_parallel(path.c_str(), vertices, faces_count, vertices_count);
     } else if (file_ext == "model") {
-        load_pure_model(path, vertices, faces_count, vertices_count);
+        Mesh mesh;
+        load_pure_model(path, mesh);
+        expand_mesh(mesh, vertices);
+        vertices_count = vertices.size();
+        faces_count = mesh.indices.size() / 3;
     } else {
         std::cout << "Cant open file of type: " << file_ext << std::endl;
-        exit(EXIT_FAILURE);
+        vertices.clear();
+        faces_count = 0;
+        vertices_count = 0;
+        return;
     }
 
     if (vertices.size() >= 3) {
-        calculate_size_and_center(vertices, model_size, model_center);
+        glm::vec3 bounds_min, bounds_max;
+        calculate_size_and_center(vertices, model_size, model_center, bounds_min, bounds_max);
     }
     
     fflush(stdin);
 }
 
+void load_model(std::string const &path, Mesh &mesh, unsigned flags, LoadControl *control, LoadStats *stats)
+{
+    auto const start = std::chrono::steady_clock::now();
+    load_mesh_stages(path, mesh, flags, control, stats);
+    if (stats != nullptr) {
+        stats->total_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats->files++;
+    }
+}
+
 void load_obj(const char *filename, std::vector<glm::vec3> &vertices,
               size_t &faces_count, size_t &vertices_count) {
-    FILE *file = fopen(filename, "r");
+    MappedFile file;
+    if (!open_mapped_file(filename, file)) {
+        return;
+    }
 
-    std::vector<size_t> vertex_idx;
-    std::vector<glm::vec3> tmp_vertices;
+    ObjChunk chunk;
+    parse_obj_chunk(file.data, file.data + file.size, chunk, nullptr);
+    close_mapped_file(file);
 
-    char *line = NULL;
-    size_t linecap = 0;
+    vertices_count += chunk.positions.size();
+    faces_count += chunk.faces_count;
 
-    while (getline(&line, &linecap, file) > 0) {
-        if (line[0] == 'v') {
-            vertices_count++;
-            glm::vec3 vertex;
-            sscanf(line + 1, "%f %f %f", &vertex.x, &vertex.y, &vertex.z);
-            tmp_vertices.push_back(vertex);
-        }
-        if (line[0] == 'f') {
-            faces_count++;
-            size_t v_index[3];
-            sscanf(line + 1, "%zu %zu %zu", &v_index[0], &v_index[1],
-                   &v_index[2]);
-            vertex_idx.push_back(v_index[0]);
-            vertex_idx.push_back(v_index[1]);
-            vertex_idx.push_back(v_index[2]);
-        }
+    size_t const first_vertex = vertices.size();
+    vertices.resize(first_vertex + chunk.indices.size());
+    if (!expand_obj_indices(chunk.indices, chunk.positions, &vertices[first_vertex])) {
+        printf("Face references a missing vertex in file: '%s'\n", filename);
+        vertices.resize(first_vertex);
+    }
+}
+
+void load_obj_parallel(const char *filename, std::vector<glm::vec3> &vertices,
+                       size_t &faces_count, size_t &vertices_count, unsigned thread_count) {
+    std::vector<ObjChunk> chunks;
+    if (!parse_obj_file(filename, thread_count, chunks, nullptr, nullptr)) {
+        return;
     }
 
-    for (size_t i = 0; i < vertex_idx.size(); i++) {
-        glm::vec3 vertex = tmp_vertices[vertex_idx[i] - 1];
-        vertices.push_back(vertex);
+    std::vector<glm::vec3> tmp_vertices;
+    std::vector<size_t> index_offsets;
+    merge_obj_positions(chunks, tmp_vertices, index_offsets);
+    vertices_count += tmp_vertices.size();
+    for (auto const &chunk : chunks) {
+        faces_count += chunk.faces_count;
     }
 
-    free(line);
-    fclose(file);
+    size_t const first_vertex = vertices.size();
+    vertices.resize(first_vertex + index_offsets.back());
+    std::vector<char> chunk_valid(chunks.size(), 1);
+    run_parallel(chunks.size(), [&](size_t i) {
+        chunk_valid[i] = expand_obj_indices(chunks[i].indices, tmp_vertices,
+                                            &vertices[first_vertex + index_offsets[i]]);
+    });
+
+    if (std::find(chunk_valid.begin(), chunk_valid.end(), 0) != chunk_valid.end()) {
+        printf("Face references a missing vertex in file: '%s'\n", filename);
+        vertices.resize(first_vertex);
+    }
 }
 
-typedef glm::u16vec3 hvec3;
-typedef glm::u16vec2 hvec2;
-// Vertices always start at address 8
-constexpr uint64_t VERTICES_OFFSET = 0x08;
-constexpr uint64_t FIRST_FACE = 0x1000200010000;
-constexpr uint64_t LOD3_END_FACE = 0x3000200010000;
+bool save_obj(std::string const &path, Mesh const &mesh) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        printf("There was an error opening file: '%s'\n", path.c_str());
+        return false;
+    }
 
-void load_pure_model(std::string const &path, std::vector<glm::vec3> &vertices,
-                     size_t &faces_count, size_t &vertices_count)
-{
-    if (path.find("LOD1") != path.npos) {
-        load_pure_model_lod1(path.c_str(), vertices, faces_count, vertices_count);
-    } else if (path.find("LOD3") != path.npos) {
-        load_pure_model_lod3(path.c_str(), vertices, faces_count, vertices_count);
-    } else {
-        printf("Unrecognized LOD level for file: %s\n", path);
+    // One record per vertex and face, a batch is split between the threads
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    size_t const record_count = vertex_count + mesh.indices.size() / 3;
+    size_t const thread_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> texts(thread_count);
+    bool ok = fprintf(file, "# %zu vertices, %zu faces\n", vertex_count, mesh.indices.size() / 3) > 0;
+    for (size_t batch = 0; ok && batch < record_count; batch += thread_count * OBJ_WRITE_BATCH) {
+        run_parallel(thread_count, [&](size_t i) {
+            size_t const first = std::min(record_count, batch + i * OBJ_WRITE_BATCH);
+            format_obj_records(mesh, first, std::min(record_count, first + OBJ_WRITE_BATCH), texts[i]);
+        });
+        for (auto const &text : texts) {
+            ok = ok && fwrite(text.data(), 1, text.size(), file) == text.size();
+        }
     }
-    fflush(stdin);
+    if (fclose(file) != 0 || !ok) {
+        printf("There was an error writing file: '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
 }
 
-static void load_pure_model_lod1(const char *filename, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count) {
-    size_t address = 0x0;
-    FILE *file = fopen(filename, "rb");
-    if (file == nullptr) {
-        printf("There was an error opening file: '%s'\n", filename);
+/**
+ * @brief Body of load_model, every step timed into stats
+ */
+static void load_mesh_stages(std::string const &path, Mesh &mesh, unsigned flags, LoadControl *control,
+                             LoadStats *stats)
+{
+    mesh = Mesh();
+    set_load_progress(control, 0.0f);
+    if (load_cancelled(control)) {
         return;
     }
-
-    // The files start with a magic number 5
-    uint32_t magic_number;
-    READ_FILE(file, &magic_number, sizeof(uint32_t), 1, return);
-    if (magic_number != 5) {
-        printf("Not a model file. Needs the magic number 5 at the beginning\n");
+    // Cache entries hold decoded positions, which half position loads avoid
+    bool const use_cache = (flags & (LOAD_HALF_POSITIONS | LOAD_NO_CACHE)) == 0;
+    bool const optimize = (flags & LOAD_OPTIMIZE) != 0;
+    bool const lods = (flags & LOAD_LODS) != 0;
+    bool const meshlets = (flags & LOAD_MESHLETS) != 0;
+    bool cache_hit = false;
+    if (use_cache) {
+        LoadStageTimer timer(stats, LOAD_STAGE_CACHE);
+        cache_hit = load_mesh_cache(path, mesh);
+    }
+    if (cache_hit) {
+        if (stats != nullptr) {
+            stats->cache_hits++;
+        }
+        // Entries saved by a plain load get the extra passes once, then replaced
+        bool const missing_optimize = optimize && !mesh.optimized;
+        bool const missing_lods = lods && mesh.lods.empty();
+        // Optimizing reorders the faces, which drops the meshlets
+        bool const missing_meshlets = meshlets && (mesh.meshlets.empty() || missing_optimize);
+        {
+            LoadStageTimer timer(stats, LOAD_STAGE_POSTPROCESS);
+            if (missing_optimize) {
+                optimize_loaded_mesh(mesh);
+            }
+            if (missing_meshlets) {
+                build_meshlets(mesh);
+            }
+            if (missing_lods) {
+                build_loaded_lods(mesh);
+            }
+        }
+        if (missing_optimize || missing_meshlets || missing_lods) {
+            LoadStageTimer timer(stats, LOAD_STAGE_CACHE);
+            save_mesh_cache(path, mesh);
+        }
+        if (!lods) {
+            mesh.lods.clear();
+        }
+        if (!meshlets) {
+            mesh.meshlets.clear();
+        }
+        {
+            LoadStageTimer timer(stats, LOAD_STAGE_POSTPROCESS);
+            extract_loaded_edges(mesh);
+        }
+        set_load_progress(control, 1.0f);
         return;
     }
 
-    // Then are followed by a weird number that changes per model
-    uint32_t weird_header;
-    READ_FILE(file, &weird_header, sizeof(uint32_t), 1, return);
-
-    //find indices 
-    uint64_t INDICES_OFFSET = 0;
-    uint64_t INDICES_COUNT = 0;
+    auto file_ext = get_file_extension(path);
+    if (file_ext == "obj") {
+        load_obj_mesh(path.c_str(), mesh, control, stats);
+    } else if (file_ext == "model") {
+        load_pure_model(path, mesh, (flags & LOAD_HALF_POSITIONS) != 0, stats);
+    } else {
+        // Callers treat an empty mesh as a failed load, this may run on a worker thread
+        std::cout << "Cant open file of type: " << file_ext << std::endl;
+        return;
+    }
+    if (load_cancelled(control)) {
+        mesh = Mesh();
+        return;
+    }
+    set_load_progress(control, PARSE_PROGRESS);
 
-    // Get indices offset
-    for (;;)
     {
-        uint64_t first_face_value;
-        INDICES_OFFSET = ftell(file);
-        READ_FILE(file, &first_face_value, sizeof(uint64_t), 1, break);
-        if (first_face_value == FIRST_FACE) {
-            SEEK_FILE(file, INDICES_OFFSET+sizeof(uint64_t) * 5, SEEK_SET, break);
-            break;
+        LoadStageTimer timer(stats, LOAD_STAGE_POSTPROCESS);
+        if (optimize) {
+            optimize_loaded_mesh(mesh);
         }
+        if (meshlets) {
+            build_meshlets(mesh);
+        }
+        if (lods) {
+            build_loaded_lods(mesh);
+        }
+        extract_loaded_edges(mesh);
     }
-
-    // Get indices count
-    for (;;)
+    mesh.faces_count = mesh.indices.size() / 3;
+    mesh.vertices_count = mesh_vertex_count(mesh);
     {
-        uint64_t first_face_value;
-        uint64_t first_face_address = ftell(file);
-        READ_FILE(file, &first_face_value, sizeof(uint64_t), 1, break);
-        if (first_face_value == FIRST_FACE || first_face_value == LOD3_END_FACE) {
-            INDICES_COUNT = static_cast<uint64_t>((first_face_address - INDICES_OFFSET) / 2);
-            break;
+        LoadStageTimer timer(stats, LOAD_STAGE_BOUNDS);
+        MeshBounds bounds;
+        if (mesh.positions.size() >= 3) {
+            calculate_bounds(mesh.positions, bounds);
+            set_mesh_bounds(bounds, mesh);
+            add_load_bytes(stats, LOAD_STAGE_BOUNDS, mesh.positions.size() * sizeof(glm::vec3));
+        } else if (mesh.half_positions.size() >= 3) {
+            // Only the box corners are decoded, so the sphere is the one
+            // through them: never smaller than the tight one
+            std::vector<glm::vec3> corners;
+            calculate_half_bounds(mesh.half_positions, corners);
+            calculate_bounds(corners, bounds);
+            set_mesh_bounds(bounds, mesh);
+            add_load_bytes(stats, LOAD_STAGE_BOUNDS, mesh.half_positions.size() * sizeof(glm::u16vec3));
         }
-        SEEK_FILE(file, first_face_address+1, SEEK_SET, break);
     }
 
-    std::vector<uint16_t> indices;
-    indices.resize(INDICES_COUNT);
+    if (use_cache && !mesh.indices.empty()) {
+        LoadStageTimer timer(stats, LOAD_STAGE_CACHE);
+        save_mesh_cache(path, mesh);
+    }
+    set_load_progress(control, 1.0f);
 
-    printf("Indices start at address: 0x%08lx\n", INDICES_OFFSET);
-    SEEK_FILE(file, INDICES_OFFSET, SEEK_SET, return);
-    READ_FILE(file, indices.data(), sizeof(uint16_t), INDICES_COUNT, return);
-    address = ftell(file); // Address is 4566*2 = 9132 = 23AC -> 23AC + F630 = 119DC
-    printf("Indices end at address: 0x%08lx\n", address);
+    fflush(stdin);
+}
 
-    // Final vertex layout struct??
-    // Size = 28 Bytes
-    struct Vertex
-    {
-        hvec3 point;
-        hvec3 normal;
-        hvec2 uv;
-        hvec3 binormals[2];
-    };
-    typedef Vertex VERTEX_TYPE;
-    assert(sizeof(VERTEX_TYPE) == 28);
+static void load_obj_mesh(const char *filename, Mesh &mesh, LoadControl *control, LoadStats *stats) {
+    std::vector<ObjChunk> chunks;
+    if (!parse_obj_file(filename, 0, chunks, control, stats) || load_cancelled(control)) {
+        return;
+    }
 
-    uint64_t VERTEX_COUNT = *std::max_element(indices.begin(), indices.end()) + 1;
-    std::vector<VERTEX_TYPE> tmp_vertices;
-    tmp_vertices.resize(VERTEX_COUNT);
+    LoadStageTimer timer(stats, LOAD_STAGE_INDEX_BUILD);
+    std::vector<size_t> index_offsets;
+    merge_obj_positions(chunks, mesh.positions, index_offsets);
+    mesh.indices.resize(index_offsets.back());
+
+    std::vector<char> chunk_valid(chunks.size(), 1);
+    run_parallel(chunks.size(), [&](size_t i) {
+        auto const &indices = chunks[i].indices;
+        uint32_t *output = mesh.indices.data() + index_offsets[i];
+        for (size_t j = 0; j < indices.size(); j++) {
+            if (indices[j] == 0 || indices[j] > mesh.positions.size()) {
+                chunk_valid[i] = 0;
+                return;
+            }
+            output[j] = static_cast<uint32_t>(indices[j] - 1);
+        }
+    });
 
-    printf("Vertices start at address: 0x%08lx\n", VERTICES_OFFSET);
-    fflush(stdin);
-    SEEK_FILE(file, VERTICES_OFFSET, SEEK_SET, return);
-    READ_FILE(file, tmp_vertices.data(), sizeof(VERTEX_TYPE), VERTEX_COUNT, return);
-    address = ftell(file); // Address is 2006*28 = 56168 = DB68 -> DB68 + 8 = DB70
-    printf("Vertices end at address: 0x%08lx\n", address);
-    fflush(stdin);
+    if (std::find(chunk_valid.begin(), chunk_valid.end(), 0) != chunk_valid.end()) {
+        printf("Face references a missing vertex in file: '%s'\n", filename);
+        mesh.positions.clear();
+        mesh.indices.clear();
+    }
+    add_load_bytes(stats, LOAD_STAGE_INDEX_BUILD,
+                   mesh.positions.size() * sizeof(glm::vec3) + mesh.indices.size() * sizeof(uint32_t));
+}
 
-    fclose(file);
-    for (size_t i = 0; i < indices.size(); i += 3)
+static bool parse_obj_file(const char *filename, unsigned thread_count, std::vector<ObjChunk> &chunks,
+                           LoadControl *control, LoadStats *stats) {
+    MappedFile file;
     {
-        size_t const max_index = i + 2;
-        for (size_t j = max_index; j >= i && j <= max_index; j--)
-        {
-            auto const short_index = indices[j];
-            auto const index = static_cast<size_t>(short_index);
-            auto tmp_vertex = tmp_vertices[index];
-            auto tmp_x = convert_float16_to_float32(tmp_vertex.point.x);
-            auto tmp_y = convert_float16_to_float32(tmp_vertex.point.y);
-            auto tmp_z = convert_float16_to_float32(tmp_vertex.point.z);
-            vertices.push_back(glm::vec3(tmp_x, tmp_y, tmp_z));
+        LoadStageTimer timer(stats, LOAD_STAGE_READ);
+        if (!open_mapped_file(filename, file)) {
+            return false;
+        }
+        add_load_bytes(stats, LOAD_STAGE_READ, file.size);
+    }
+    LoadStageTimer timer(stats, LOAD_STAGE_PARSE);
+    add_load_bytes(stats, LOAD_STAGE_PARSE, file.size);
+
+    size_t chunk_count = thread_count;
+    if (chunk_count == 0) {
+        chunk_count = std::max(1u, std::thread::hardware_concurrency());
+        chunk_count = std::min(chunk_count, file.size / OBJ_MIN_CHUNK_SIZE + 1);
+    }
+    chunk_count = std::max<size_t>(1, std::min(chunk_count, file.size));
+
+    // Chunk boundaries are moved forward to the next line start so that every
+    // record is parsed by exactly one thread
+    std::vector<char const *> bounds(chunk_count + 1);
+    char const *const file_end = file.data + file.size;
+    bounds[0] = file.data;
+    bounds[chunk_count] = file_end;
+    for (size_t i = 1; i < chunk_count; i++) {
+        char const *bound = std::max(bounds[i - 1], file.data + file.size / chunk_count * i);
+        if (bound != file.data && bound < file_end && bound[-1] != '\n') {
+            auto line_end = static_cast<char const *>(memchr(bound, '\n', file_end - bound));
+            bound = line_end == nullptr ? file_end : line_end + 1;
         }
+        bounds[i] = bound;
     }
 
-    vertices_count = vertices.size();
-    faces_count = static_cast<size_t>(INDICES_COUNT / 3);
+    ObjParseProgress progress;
+    progress.control = control;
+    progress.bytes_parsed = 0;
+    progress.total_bytes = file.size;
+
+    chunks.clear();
+    chunks.resize(chunk_count);
+    run_parallel(chunk_count, [&](size_t i) {
+        parse_obj_chunk(bounds[i], bounds[i + 1], chunks[i], control != nullptr ? &progress : nullptr);
+    });
+    close_mapped_file(file);
+    return true;
 }
 
-static void load_pure_model_lod3(const char *filename, std::vector<glm::vec3> &vertices,
-              size_t &faces_count, size_t &vertices_count) {
-    size_t address = 0x0;
-    FILE *file = fopen(filename, "rb");
-    if (file == nullptr) {
-        printf("There was an error opening file: '%s'\n", filename);
-        return;
+static void merge_obj_positions(std::vector<ObjChunk> &chunks, std::vector<glm::vec3> &positions,
+                                std::vector<size_t> &index_offsets) {
+    // OBJ indices are absolute, so concatenating the chunks in file order
+    // reproduces the serial vertex numbering exactly
+    std::vector<size_t> position_offsets(chunks.size() + 1, 0);
+    index_offsets.assign(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        position_offsets[i + 1] = position_offsets[i] + chunks[i].positions.size();
+        index_offsets[i + 1] = index_offsets[i] + chunks[i].indices.size();
     }
 
-    uint32_t magic_number;
-    READ_FILE(file, &magic_number, sizeof(uint32_t), 1, return);
-    if (magic_number != 5) {
-        printf("Not a model file. Needs the magic number 5 at the beginning\n");
-        return;
+    positions.resize(position_offsets.back());
+    run_parallel(chunks.size(), [&](size_t i) {
+        std::copy(chunks[i].positions.begin(), chunks[i].positions.end(),
+                  positions.begin() + position_offsets[i]);
+        std::vector<glm::vec3>().swap(chunks[i].positions);
+    });
+}
+
+static void parse_obj_chunk(char const *begin, char const *end, ObjChunk &chunk, ObjParseProgress *progress) {
+    char const *line = begin;
+    char const *reported = begin;
+    while (line < end) {
+        if (progress != nullptr && static_cast<size_t>(line - reported) >= OBJ_PROGRESS_STEP) {
+            if (!report_obj_progress(progress, line - reported)) {
+                return;
+            }
+            reported = line;
+        }
+
+        auto line_end = static_cast<char const *>(memchr(line, '\n', end - line));
+        if (line_end == nullptr) {
+            line_end = end;
+        }
+
+        if (line_end - line > 1 && is_blank(line[1])) {
+            if (line[0] == 'v') {
+                glm::vec3 vertex(0.0f);
+                char const *cursor = line + 1;
+                cursor = parse_float(cursor, line_end, vertex.x);
+                cursor = parse_float(cursor, line_end, vertex.y);
+                parse_float(cursor, line_end, vertex.z);
+                chunk.positions.push_back(vertex);
+            } else if (line[0] == 'f') {
+                chunk.faces_count++;
+                size_t v_index[3] = {0, 0, 0};
+                char const *cursor = line + 1;
+                cursor = parse_index(cursor, line_end, v_index[0]);
+                cursor = parse_index(cursor, line_end, v_index[1]);
+                parse_index(cursor, line_end, v_index[2]);
+                chunk.indices.push_back(v_index[0]);
+                chunk.indices.push_back(v_index[1]);
+                chunk.indices.push_back(v_index[2]);
+            }
+        }
+
+        line = line_end + 1;
     }
+}
 
-    uint32_t weird_header;
-    READ_FILE(file, &weird_header, sizeof(uint32_t), 1, return);
+static bool report_obj_progress(ObjParseProgress *progress, size_t bytes) {
+    size_t const parsed = progress->bytes_parsed.fetch_add(bytes) + bytes;
+    set_load_progress(progress->control, PARSE_PROGRESS * parsed / progress->total_bytes);
+    return !load_cancelled(progress->control);
+}
 
-    // Final vertex layout struct??
-    // Size = 24 Bytes
-    struct Vertex
-    {
-        hvec3 point;
-        hvec3 normal;
-        hvec3 binormals[2];
-    };
-    typedef Vertex VERTEX_TYPE;
-    assert(sizeof(VERTEX_TYPE) == 24);
+static void optimize_loaded_mesh(Mesh &mesh) {
+    // The viewer shows the resulting ACMR itself
+    optimize_mesh(mesh);
+    // Dropped vertices no face used
+    mesh.vertices_count = mesh_vertex_count(mesh);
+}
 
-    std::vector<VERTEX_TYPE> tmp_vertices;
-    constexpr uint64_t VERTICES_OFFSET = 0x08;
-    constexpr uint64_t VERTEX_COUNT = 486;
-    SEEK_FILE(file, VERTICES_OFFSET, SEEK_SET, return);
-    
-    printf("Vertices start at address: 0x%08lx\n", VERTICES_OFFSET);
-    for (uint64_t vertex_count = 0; vertex_count != VERTEX_COUNT; vertex_count++)
-    {
-        VERTEX_TYPE vertex;
-        READ_FILE(file, &vertex, sizeof(VERTEX_TYPE), 1, break);
-        tmp_vertices.push_back(vertex);
+static void build_loaded_lods(Mesh &mesh) {
+    build_mesh_lods(mesh);
+    if (!mesh.optimized) {
+        return;
     }
-    // Address is 486*24 = 11664 = 2D90 -> 2D90 + 8 = 2D98
-    address = ftell(file);
-    printf("Vertices end at address: 0x%08lx\n", address);
+    for (auto &lod : mesh.lods) {
+        optimize_vertex_cache(lod.indices, mesh_vertex_count(mesh));
+    }
+}
 
-    //find indices 
-    std::vector<uint16_t> indices;
-    uint64_t INDICES_OFFSET = 0;
-    uint64_t INDICES_COUNT = 0;
+/**
+ * @brief Edges are cheap to rebuild, so the cache does not store them
+ */
+static void extract_loaded_edges(Mesh &mesh) {
+    extract_edges(mesh.indices, mesh.edges);
+    mesh.edges_count = mesh.edges.size() / 2;
+}
 
-    SEEK_FILE(file, 0, SEEK_SET, return);
-    for (;;)
-    {
-        uint64_t first_face_value;
-        INDICES_OFFSET = ftell(file);
-        READ_FILE(file, &first_face_value, sizeof(uint64_t), 1, break);
-        if (first_face_value == FIRST_FACE) {
-            break;
+static bool load_cancelled(LoadControl const *control) {
+    return control != nullptr && control->cancelled.load();
+}
+
+static void set_load_progress(LoadControl *control, float progress) {
+    if (control != nullptr) {
+        control->progress.store(control->progress_offset + progress * control->progress_scale);
+    }
+}
+
+static bool expand_obj_indices(std::vector<size_t> const &indices, std::vector<glm::vec3> const &positions,
+                               glm::vec3 *output) {
+    for (size_t i = 0; i < indices.size(); i++) {
+        if (indices[i] == 0 || indices[i] > positions.size()) {
+            return false;
         }
+        output[i] = positions[indices[i] - 1];
     }
+    return true;
+}
 
-    for (;;)
-    {
-        uint64_t first_face_value;
-        uint64_t first_face_address = ftell(file);
-        READ_FILE(file, &first_face_value, sizeof(uint64_t), 1, break);
-        if (first_face_value == LOD3_END_FACE) {
-            INDICES_COUNT = static_cast<uint64_t>((first_face_address - INDICES_OFFSET) / 2);
-            break;
+/**
+ * @brief Text of the records [first, last), vertices come before faces
+ */
+static void format_obj_records(Mesh const &mesh, size_t first, size_t last, std::string &text) {
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    char record[96];
+    text.clear();
+    for (size_t i = first; i < last; i++) {
+        int length = 0;
+        if (i < vertex_count) {
+            glm::vec3 position;
+            if (mesh.positions.empty()) {
+                convert_float16_to_float32(&mesh.half_positions[i].x, &position.x, 3);
+            } else {
+                position = mesh.positions[i];
+            }
+            // Six decimals keep the parser on its exact fast path for unit sized models
+            length = snprintf(record, sizeof(record), "v %.6f %.6f %.6f\n", position.x, position.y, position.z);
+        } else {
+            uint32_t const *face = &mesh.indices[(i - vertex_count) * 3];
+            length = snprintf(record, sizeof(record), "f %u %u %u\n", face[0] + 1, face[1] + 1, face[2] + 1);
         }
-        SEEK_FILE(file, first_face_address+1, SEEK_SET, break);
+        text.append(record, static_cast<size_t>(length));
     }
-    assert(INDICES_COUNT == 732);
+}
 
-    SEEK_FILE(file, INDICES_OFFSET, SEEK_SET, return);
-    printf("Indices start at address: 0x%08lx\n", INDICES_OFFSET);
-    for (uint64_t index_count = 0; index_count < INDICES_COUNT; index_count++)
-    {
-        uint16_t index;
-        READ_FILE(file, &index, sizeof(uint16_t), 1, break);
-        indices.push_back(index);
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static char const *skip_blanks(char const *cursor, char const *end) {
+    while (cursor < end && is_blank(*cursor)) {
+        cursor++;
     }
-    // Address is 732*2 = 1464 = 5B8 -> 5B8 + 3338 = 38F0
-    address = ftell(file);
-    printf("Indices end at address: 0x%08lx\n", address);
+    return cursor;
+}
 
-    fclose(file);
-    for (size_t i = 0; i < indices.size(); i += 3)
-    {
-        size_t const max_index = i + 2;
-        for (size_t j = max_index; j >= i && j <= max_index; j--)
-        {
-            auto const short_index = indices[j];
-            auto const index = static_cast<size_t>(short_index);
-            auto tmp_vertex = tmp_vertices[index];
-            auto tmp_x = convert_float16_to_float32(tmp_vertex.point.x);
-            auto tmp_y = convert_float16_to_float32(tmp_vertex.point.y);
-            auto tmp_z = convert_float16_to_float32(tmp_vertex.point.z);
-            vertices.push_back(glm::vec3(tmp_x, tmp_y, tmp_z));
+static char const *parse_float(char const *cursor, char const *end, float &value) {
+    cursor = skip_blanks(cursor, end);
+    char const *const token = cursor;
+    char const *token_end = cursor;
+    while (token_end < end && !is_blank(*token_end)) {
+        token_end++;
+    }
+
+    // Fast path: a mantissa that fits a float exactly scaled by an exact power
+    // of ten rounds once, so it gives the same bits as strtof
+    static float const powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f,
+                                          1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+    bool const negative = cursor < token_end && *cursor == '-';
+    if (cursor < token_end && (*cursor == '-' || *cursor == '+')) {
+        cursor++;
+    }
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int digits = 0;
+    for (; cursor < token_end && is_digit(*cursor) && mantissa <= (1u << 24); cursor++, digits++) {
+        mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+    }
+    if (cursor < token_end && *cursor == '.') {
+        for (cursor++; cursor < token_end && is_digit(*cursor) && mantissa <= (1u << 24); cursor++, digits++) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*cursor - '0');
+            exponent--;
         }
     }
+    if (cursor == token_end && digits > 0 && mantissa <= (1u << 24) && exponent >= -10) {
+        float const magnitude = static_cast<float>(mantissa) / powers_of_ten[-exponent];
+        value = negative ? -magnitude : magnitude;
+        return token_end;
+    }
 
-    vertices_count = vertices.size();
-    faces_count = static_cast<size_t>(INDICES_COUNT / 3);
+    // Anything else (exponents, long mantissas, inf/nan) goes through libc on
+    // a small stack copy of the token so the result matches sscanf exactly
+    char buffer[64];
+    size_t const token_size = static_cast<size_t>(token_end - token);
+    if (token_size == 0 || token_size >= sizeof(buffer)) {
+        return token_end;
+    }
+    memcpy(buffer, token, token_size);
+    buffer[token_size] = '\0';
+    char *parsed_end = nullptr;
+    float const parsed = strtof(buffer, &parsed_end);
+    if (parsed_end != buffer) {
+        value = parsed;
+    }
+    return token_end;
 }
 
-float convert_float16_to_float32(short float16_value) {
-  // Implementation code by milhidaka@github
-  // MSB -> LSB
-  // float16=1bit: sign, 5bit: exponent, 10bit: fraction
-  // float32=1bit: sign, 8bit: exponent, 23bit: fraction
-  // for normal exponent(1 to 0x1e): value=2**(exponent-15)*(1.fraction)
-  // for denormalized exponent(0): value=2**-14*(0.fraction)
-  uint32_t sign = float16_value >> 15;
-  uint32_t exponent = (float16_value >> 10) & 0x1F;
-  uint32_t fraction = (float16_value & 0x3FF);
-  uint32_t float32_value;
-  if (exponent == 0)
-  {
-    if (fraction == 0)
-    {
-      // zero
-      float32_value = (sign << 31);
+static char const *parse_index(char const *cursor, char const *end, size_t &index) {
+    cursor = skip_blanks(cursor, end);
+    size_t value = 0;
+    bool has_digits = false;
+    for (; cursor < end && is_digit(*cursor); cursor++) {
+        value = value * 10 + static_cast<size_t>(*cursor - '0');
+        has_digits = true;
     }
-    else
-    {
-      // can be represented as ordinary value in float32
-      // 2 ** -14 * 0.0101
-      // => 2 ** -16 * 1.0100
-      // int int_exponent = -14;
-      exponent = 127 - 14;
-      while ((fraction & (1 << 10)) == 0)
-      {
-        //int_exponent--;
-        exponent--;
-        fraction <<= 1;
-      }
-      fraction &= 0x3FF;
-      // int_exponent += 127;
-      float32_value = (sign << 31) | (exponent << 23) | (fraction << 13);  
-    }    
-  }
-  else if (exponent == 0x1F)
-  {
-    /* Inf or NaN */
-    float32_value = (sign << 31) | (0xFF << 23) | (fraction << 13);
-  }
-  else
-  {
-    /* ordinary number */
-    float32_value = (sign << 31) | ((exponent + (127-15)) << 23) | (fraction << 13);
-  }
-  
-  return *((float*)&float32_value);
+    if (has_digits) {
+        index = value;
+    }
+    // Skip the texture/normal references of "v/vt/vn" groups
+    while (cursor < end && !is_blank(*cursor)) {
+        cursor++;
+    }
+    return cursor;
 }
 
-void calculate_size_and_center(std::vector<glm::vec3> const &vertices, float &model_size, glm::vec3 &model_center) {
-    glm::vec3 min_vert(0.0f);
-    glm::vec3 max_vert(0.0f);
-    for (auto vertex : vertices)
-    {
-        if (vertex.x < min_vert.x) {
-            min_vert.x = vertex.x;
-        }
-        if (vertex.y < min_vert.y) {
-            min_vert.y = vertex.y;
-        }
-        if (vertex.z < min_vert.z) {
-            min_vert.z = vertex.z;
-        }
+void calculate_size_and_center(std::vector<glm::vec3> const &vertices, float &model_size, glm::vec3 &model_center,
+                               glm::vec3 &bounds_min, glm::vec3 &bounds_max) {
+    MeshBounds bounds;
+    calculate_bounds(vertices, bounds);
+    glm::vec3 const size = bounds.max - bounds.min;
+    model_size = std::max(size.x, std::max(size.y, size.z));
+    model_center = (bounds.min + bounds.max) * 0.5f;
+    bounds_min = bounds.min;
+    bounds_max = bounds.max;
+}
 
-        if (vertex.x > max_vert.x) {
-            max_vert.x = vertex.x;
-        }
-        if (vertex.y > min_vert.y) {
-            max_vert.y = vertex.y;
-        }
-        if (vertex.z > max_vert.z) {
-            max_vert.z = vertex.z;
+void calculate_half_bounds(std::vector<glm::u16vec3> const &half_positions, std::vector<glm::vec3> &bounds) {
+    // Mapping negative halves to the low keys makes integer order match
+    // float order, so only the two extremes per axis need decoding
+    auto order_key = [](uint16_t half) {
+        return static_cast<uint16_t>((half & 0x8000) ? ~half : (half | 0x8000));
+    };
+
+    glm::u16vec3 min_half = half_positions[0];
+    glm::u16vec3 max_half = half_positions[0];
+    for (auto const &half : half_positions)
+    {
+        for (int i = 0; i < 3; i++) {
+            if (order_key(half[i]) < order_key(min_half[i])) {
+                min_half[i] = half[i];
+            }
+            if (order_key(half[i]) > order_key(max_half[i])) {
+                max_half[i] = half[i];
+            }
         }
     }
 
-    auto const size_vec = (max_vert - min_vert);
-    model_size = size_vec.x;
-    for (int i = 1; i < size_vec.length(); i++) {
-        if (model_size < size_vec[i]) {
-            model_size = size_vec[i];
-        }
+    bounds.resize(2);
+    for (int i = 0; i < 3; i++) {
+        bounds[0][i] = convert_float16_to_float32(min_half[i]);
+        bounds[1][i] = convert_float16_to_float32(max_half[i]);
     }
-    model_center = (max_vert + min_vert) * 0.5f;
 }
-
-#undef READ_FILE
@@ -2,6 +2,41 @@
 #define LOADER_H_
 
 #include "../includes/common.h"
+#include "load_stats.hpp"
+#include "mesh.hpp"
+
+#include <atomic>
+
+/**
+ * @brief Optional behaviours of load_model, combined as a bitmask
+ */
+enum LoadFlags : unsigned {
+    // Keep half precision sources (.model) as raw halves for the GPU
+    LOAD_HALF_POSITIONS = 1u << 0,
+    // Reorder faces and vertices for the GPU caches, see optimize_mesh
+    LOAD_OPTIMIZE = 1u << 1,
+    // Build a chain of simplified levels, see build_mesh_lods
+    LOAD_LODS = 1u << 2,
+    // Split into clusters for culling, see build_meshlets
+    LOAD_MESHLETS = 1u << 3,
+    // Always read the source file, neither reading nor writing the mesh cache
+    LOAD_NO_CACHE = 1u << 4,
+};
+
+/**
+ * @brief Lets another thread follow and cancel a running load_model
+ */
+struct LoadControl {
+    // 0 to 1, only moves forward during a load
+    std::atomic<float> progress{0.0f};
+    // Set to make load_model stop early and return an empty mesh
+    std::atomic<bool> cancelled{false};
+    // Slice of progress the current model maps to, set by the loading thread
+    // when one load covers several models
+    float progress_offset = 0.0f;
+    float progress_scale = 1.0f;
+};
+
 /**
  * @brief Loads any model type
  *
@@ -13,4 +48,76 @@
 void load_model(std::string const &path, std::vector<glm::vec3> &vertices,
               size_t &faces_count, size_t &vertices_count, float &model_size, glm::vec3 &model_center);
 
+/**
+ * @brief Loads any model type as an indexed mesh
+ *
+ * Positions are kept unique and faces reference them through the index
+ * buffer, so nothing is duplicated per triangle corner. The unique edges are
+ * always extracted for wireframe drawing. Previously loaded files are read
+ * back from the mesh cache while they stay unchanged.
+ *
+ * @param path Path to the file
+ * @param mesh Output mesh, replaced entirely, empty if the file can't be loaded
+ * @param flags Bitmask of LoadFlags
+ * @param control Optional progress/cancel state shared with another thread
+ * @param stats Optional per-stage durations and byte counts, added to
+ */
+void load_model(std::string const &path, Mesh &mesh, unsigned flags = 0, LoadControl *control = nullptr,
+                LoadStats *stats = nullptr);
+
+/**
+ * @brief Loads a Wavefront OBJ file as a de-indexed triangle list
+ *
+ * The file is memory-mapped (or read in one go when mapping is unavailable)
+ * and parsed in place without per-line copies.
+ *
+ * @param filename Path to the file
+ * @param vertices Vector the triangle corners are appended to
+ * @param faces_count Incremented once per face record
+ * @param vertices_count Incremented once per vertex record
+ */
+void load_obj(const char *filename, std::vector<glm::vec3> &vertices,
+              size_t &faces_count, size_t &vertices_count);
+
+/**
+ * @brief Loads a Wavefront OBJ file using several threads
+ *
+ * The file is split into newline-aligned chunks that are parsed in parallel
+ * and merged in file order, so the output is identical to load_obj.
+ *
+ * @param filename Path to the file
+ * @param vertices Vector the triangle corners are appended to
+ * @param faces_count Incremented once per face record
+ * @param vertices_count Incremented once per vertex record
+ * @param thread_count Number of chunks to parse, 0 picks one per core
+ */
+void load_obj_parallel(const char *filename, std::vector<glm::vec3> &vertices,
+                       size_t &faces_count, size_t &vertices_count, unsigned thread_count = 0);
+
+/**
+ * @brief Writes a mesh as a Wavefront OBJ file, vertices then faces
+ *
+ * Records are formatted by several threads in batches and written in order,
+ * so the file is identical for any thread count.
+ *
+ * @param path Output path
+ * @param mesh Mesh with float or half positions
+ * @return Returns false and prints the problem if the file can't be written
+ */
+bool save_obj(std::string const &path, Mesh const &mesh);
+
+/**
+ * @brief Bounding box of a set of points, with its largest side and center
+ *
+ * Wraps calculate_bounds for callers that don't need the bounding sphere.
+ *
+ * @param vertices Points to bound
+ * @param model_size Output largest side of the box
+ * @param model_center Output center of the box
+ * @param bounds_min Output lowest corner
+ * @param bounds_max Output highest corner
+ */
+void calculate_size_and_center(std::vector<glm::vec3> const &vertices, float &model_size, glm::vec3 &model_center,
+                               glm::vec3 &bounds_min, glm::vec3 &bounds_max);
+
 #endif  // LOADER_H_
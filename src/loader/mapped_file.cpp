@@ -0,0 +1,87 @@
+#include "mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HAS_MMAP 1
+#endif
+
+static bool read_whole_file(const char *filename, MappedFile &file);
+
+bool open_mapped_file(const char *filename, MappedFile &file) {
+    close_mapped_file(file);
+
+#ifdef HAS_MMAP
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("There was an error opening file: '%s'\n", filename);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void *data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            // We walk the bytes front to back exactly once
+            madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+            file.data = static_cast<const char *>(data);
+            file.size = static_cast<size_t>(info.st_size);
+            file.is_mapped = true;
+            close(fd);
+            return true;
+        }
+    }
+    close(fd);
+#endif
+
+    return read_whole_file(filename, file);
+}
+
+void close_mapped_file(MappedFile &file) {
+#ifdef HAS_MMAP
+    if (file.is_mapped) {
+        munmap(const_cast<char *>(file.data), file.size);
+    }
+#endif
+    file.data = nullptr;
+    file.size = 0;
+    file.is_mapped = false;
+    std::vector<char>().swap(file.buffer);
+}
+
+static bool read_whole_file(const char *filename, MappedFile &file) {
+    FILE *stream = fopen(filename, "rb");
+    if (stream == nullptr) {
+        printf("There was an error opening file: '%s'\n", filename);
+        return false;
+    }
+
+    long file_size = 0;
+    if (fseek(stream, 0, SEEK_END) == 0 && (file_size = ftell(stream)) > 0) {
+        file.buffer.reserve(static_cast<size_t>(file_size));
+    }
+    rewind(stream);
+
+    // Pipes and other unsized files are read in large blocks until EOF
+    char block[1 << 16];
+    size_t amount_read = 0;
+    while ((amount_read = fread(block, 1, sizeof(block), stream)) > 0) {
+        file.buffer.insert(file.buffer.end(), block, block + amount_read);
+    }
+    if (ferror(stream) != 0) {
+        printf("There was an error reading file: '%s'\n", filename);
+        fclose(stream);
+        std::vector<char>().swap(file.buffer);
+        return false;
+    }
+    fclose(stream);
+
+    file.data = file.buffer.data();
+    file.size = file.buffer.size();
+    file.is_mapped = false;
+    return true;
+}
+
+#undef HAS_MMAP
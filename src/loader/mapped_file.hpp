@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include "../includes/common.h"
+
+/**
+ * @brief Read-only view over the whole contents of a file
+ *
+ * The bytes are memory-mapped when the platform allows it, otherwise they
+ * are read in one go into buffer. Either way data/size describe the file.
+ */
+struct MappedFile {
+    const char *data = nullptr;
+    size_t size = 0;
+    bool is_mapped = false;
+    std::vector<char> buffer;
+};
+
+/**
+ * @brief Maps a file into memory, falling back to a buffered read
+ *
+ * @param filename Path to the file
+ * @param file Output view over the file contents
+ * @return Returns false if the file could not be opened or read
+ */
+bool open_mapped_file(const char *filename, MappedFile &file);
+
+/**
+ * @brief Releases the mapping or buffer held by a MappedFile
+ *
+ * @param file File previously opened with open_mapped_file
+ */
+void close_mapped_file(MappedFile &file);
+
+#endif  // MAPPED_FILE_H_
@@ -0,0 +1,38 @@
+#include "mesh.hpp"
+
+#include <cstring>
+
+size_t mesh_vertex_count(Mesh const &mesh) {
+    return mesh.positions.empty() ? mesh.half_positions.size() : mesh.positions.size();
+}
+
+GLenum mesh_index_type(Mesh const &mesh) {
+    return mesh_vertex_count(mesh) <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+void pack_mesh_indices(Mesh const &mesh, std::vector<uint8_t> &index_data) {
+    index_data.clear();
+    pack_indices(mesh.indices, mesh_index_type(mesh), index_data);
+}
+
+void pack_indices(std::vector<uint32_t> const &indices, GLenum index_type, std::vector<uint8_t> &index_data) {
+    size_t const start = index_data.size();
+    if (index_type == GL_UNSIGNED_INT) {
+        index_data.resize(start + indices.size() * sizeof(uint32_t));
+        memcpy(index_data.data() + start, indices.data(), indices.size() * sizeof(uint32_t));
+        return;
+    }
+
+    index_data.resize(start + indices.size() * sizeof(uint16_t));
+    auto short_indices = reinterpret_cast<uint16_t *>(index_data.data() + start);
+    for (size_t i = 0; i < indices.size(); i++) {
+        short_indices[i] = static_cast<uint16_t>(indices[i]);
+    }
+}
+
+void expand_mesh(Mesh const &mesh, std::vector<glm::vec3> &vertices) {
+    vertices.reserve(vertices.size() + mesh.indices.size());
+    for (auto index : mesh.indices) {
+        vertices.push_back(mesh.positions[index]);
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef MESH_H_
+#define MESH_H_
+
+#include "../includes/common.h"
+
+/**
+ * @brief Coarser version of a mesh over the same vertices
+ */
+struct MeshLod {
+    std::vector<uint32_t> indices;
+    // Farthest the surface moved from the original, in model units
+    float error = 0.0f;
+};
+
+/**
+ * @brief Cluster of nearby faces with bounds for culling
+ */
+struct Meshlet {
+    uint32_t first_index;
+    uint32_t index_count;
+    glm::vec3 center;
+    float radius;
+    // Average face normal and sine of how far the normals spread from it,
+    // 1 when the faces spread too much to ever be back facing together
+    glm::vec3 cone_axis;
+    float cone_cutoff;
+};
+
+/**
+ * @brief Indexed triangle mesh: unique positions plus 3 indices per face
+ *
+ * Meshes loaded with LOAD_HALF_POSITIONS from half precision sources keep
+ * the raw half_positions instead and leave positions empty.
+ */
+struct Mesh {
+    std::vector<glm::vec3> positions;
+    std::vector<glm::u16vec3> half_positions;
+    std::vector<uint32_t> indices;
+    size_t faces_count = 0;
+    size_t vertices_count = 0;
+    size_t edges_count = 0;
+    float model_size = 0.0f;
+    glm::vec3 model_center = glm::vec3(0.0f);
+    glm::vec3 bounds_min = glm::vec3(0.0f);
+    glm::vec3 bounds_max = glm::vec3(0.0f);
+    // Bounding sphere around model_center
+    float bounding_radius = 0.0f;
+    // Set once optimize_mesh reordered the faces and vertices
+    bool optimized = false;
+    // Simplified levels from build_mesh_lods, finest first
+    std::vector<MeshLod> lods;
+    // Clusters of indices from build_meshlets, in index order
+    std::vector<Meshlet> meshlets;
+    // Unique edges of indices as index pairs, from extract_edges
+    std::vector<uint32_t> edges;
+};
+
+/**
+ * @brief Number of unique vertices, whichever position array is in use
+ *
+ * @param mesh Mesh to count
+ */
+size_t mesh_vertex_count(Mesh const &mesh);
+
+/**
+ * @brief Tells if the mesh indices fit in 16 bits
+ *
+ * @param mesh Mesh to check
+ * @return Returns GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ */
+GLenum mesh_index_type(Mesh const &mesh);
+
+/**
+ * @brief Packs the mesh indices using the narrowest type that fits
+ *
+ * @param mesh Mesh to pack
+ * @param index_data Output bytes ready for an element array buffer
+ */
+void pack_mesh_indices(Mesh const &mesh, std::vector<uint8_t> &index_data);
+
+/**
+ * @brief Appends indices to a buffer as GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+ *
+ * @param indices Indices to pack
+ * @param index_type Type from mesh_index_type
+ * @param index_data Bytes the packed indices are appended to
+ */
+void pack_indices(std::vector<uint32_t> const &indices, GLenum index_type, std::vector<uint8_t> &index_data);
+
+/**
+ * @brief Expands an indexed mesh into a flat triangle list
+ *
+ * @param mesh Mesh to expand
+ * @param vertices Vector the triangle corners are appended to
+ */
+void expand_mesh(Mesh const &mesh, std::vector<glm::vec3> &vertices);
+
+#endif  // MESH_H_
@@ -0,0 +1,220 @@
+#include "mesh_bounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include "../utils/parallel.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MESH_BOUNDS_X86 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MESH_BOUNDS_NEON 1
+#endif
+
+static void reduce_box(glm::vec3 const *points, size_t count, glm::vec3 &low, glm::vec3 &high);
+static float reduce_distance(glm::vec3 const *points, size_t count, glm::vec3 const &center);
+
+void calculate_bounds(std::vector<glm::vec3> const &positions, MeshBounds &bounds, unsigned thread_count) {
+    bounds = MeshBounds();
+    size_t const count = positions.size();
+    if (count == 0) {
+        return;
+    }
+    size_t task_count = thread_count;
+    if (task_count == 0) {
+        task_count = count < BOUNDS_PARALLEL_VERTICES ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+    task_count = std::min(task_count, count);
+
+    float const infinity = std::numeric_limits<float>::infinity();
+    std::vector<glm::vec3> lows(task_count, glm::vec3(infinity));
+    std::vector<glm::vec3> highs(task_count, glm::vec3(-infinity));
+    run_parallel(task_count, [&](size_t task) {
+        size_t const first = count * task / task_count;
+        size_t const last = count * (task + 1) / task_count;
+        reduce_box(positions.data() + first, last - first, lows[task], highs[task]);
+    });
+    bounds.min = lows[0];
+    bounds.max = highs[0];
+    for (size_t task = 1; task < task_count; task++) {
+        bounds.min = glm::min(bounds.min, lows[task]);
+        bounds.max = glm::max(bounds.max, highs[task]);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        // Only NaNs on this axis
+        if (bounds.min[axis] > bounds.max[axis]) {
+            bounds.min[axis] = bounds.max[axis] = 0.0f;
+        }
+    }
+
+    glm::vec3 const center = (bounds.min + bounds.max) * 0.5f;
+    std::vector<float> distances(task_count, 0.0f);
+    run_parallel(task_count, [&](size_t task) {
+        size_t const first = count * task / task_count;
+        size_t const last = count * (task + 1) / task_count;
+        distances[task] = reduce_distance(positions.data() + first, last - first, center);
+    });
+    bounds.radius = std::sqrt(*std::max_element(distances.begin(), distances.end()));
+}
+
+void set_mesh_bounds(MeshBounds const &bounds, Mesh &mesh) {
+    glm::vec3 const size = bounds.max - bounds.min;
+    mesh.bounds_min = bounds.min;
+    mesh.bounds_max = bounds.max;
+    mesh.model_size = std::max(size.x, std::max(size.y, size.z));
+    mesh.model_center = (bounds.min + bounds.max) * 0.5f;
+    mesh.bounding_radius = bounds.radius;
+}
+
+#ifdef MESH_BOUNDS_X86
+/**
+ * @brief Transposes 4 packed points (x0 y0 z0 x1, y1 z1 x2 y2, z2 x3 y3 z3)
+ * into one register per axis
+ */
+__attribute__((target("sse"), always_inline))
+static inline void load_points_sse(float const *floats, __m128 &x, __m128 &y, __m128 &z) {
+    __m128 const a = _mm_loadu_ps(floats);
+    __m128 const b = _mm_loadu_ps(floats + 4);
+    __m128 const c = _mm_loadu_ps(floats + 8);
+    __m128 const xy = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));  // x2 y2 x3 y3
+    __m128 const yz = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));  // y0 z0 y1 z1
+    x = _mm_shuffle_ps(a, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    z = _mm_shuffle_ps(yz, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+// _mm_min_ps and _mm_max_ps return the second operand when either is NaN,
+// so the accumulators always go second and NaN points are skipped
+__attribute__((target("sse")))
+static size_t reduce_box_sse(float const *floats, size_t count, glm::vec3 &low, glm::vec3 &high) {
+    __m128 low_x = _mm_set1_ps(low.x), low_y = _mm_set1_ps(low.y), low_z = _mm_set1_ps(low.z);
+    __m128 high_x = _mm_set1_ps(high.x), high_y = _mm_set1_ps(high.y), high_z = _mm_set1_ps(high.z);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load_points_sse(floats + i * 3, x, y, z);
+        low_x = _mm_min_ps(x, low_x);
+        low_y = _mm_min_ps(y, low_y);
+        low_z = _mm_min_ps(z, low_z);
+        high_x = _mm_max_ps(x, high_x);
+        high_y = _mm_max_ps(y, high_y);
+        high_z = _mm_max_ps(z, high_z);
+    }
+
+    float lanes[6][4];
+    _mm_storeu_ps(lanes[0], low_x);
+    _mm_storeu_ps(lanes[1], low_y);
+    _mm_storeu_ps(lanes[2], low_z);
+    _mm_storeu_ps(lanes[3], high_x);
+    _mm_storeu_ps(lanes[4], high_y);
+    _mm_storeu_ps(lanes[5], high_z);
+    for (int axis = 0; axis < 3; axis++) {
+        for (int lane = 0; lane < 4; lane++) {
+            low[axis] = std::min(low[axis], lanes[axis][lane]);
+            high[axis] = std::max(high[axis], lanes[axis + 3][lane]);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("sse")))
+static size_t reduce_distance_sse(float const *floats, size_t count, glm::vec3 const &center, float &farthest) {
+    __m128 const center_x = _mm_set1_ps(center.x), center_y = _mm_set1_ps(center.y), center_z = _mm_set1_ps(center.z);
+    __m128 best = _mm_set1_ps(farthest);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load_points_sse(floats + i * 3, x, y, z);
+        x = _mm_sub_ps(x, center_x);
+        y = _mm_sub_ps(y, center_y);
+        z = _mm_sub_ps(z, center_z);
+        __m128 const squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        best = _mm_max_ps(squared, best);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, best);
+    farthest = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    return i;
+}
+#endif
+
+#ifdef MESH_BOUNDS_NEON
+// vld3q deinterleaves the points, the nm variants skip NaNs
+static size_t reduce_box_neon(float const *floats, size_t count, glm::vec3 &low, glm::vec3 &high) {
+    float32x4_t low_x = vdupq_n_f32(low.x), low_y = vdupq_n_f32(low.y), low_z = vdupq_n_f32(low.z);
+    float32x4_t high_x = vdupq_n_f32(high.x), high_y = vdupq_n_f32(high.y), high_z = vdupq_n_f32(high.z);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t const points = vld3q_f32(floats + i * 3);
+        low_x = vminnmq_f32(low_x, points.val[0]);
+        low_y = vminnmq_f32(low_y, points.val[1]);
+        low_z = vminnmq_f32(low_z, points.val[2]);
+        high_x = vmaxnmq_f32(high_x, points.val[0]);
+        high_y = vmaxnmq_f32(high_y, points.val[1]);
+        high_z = vmaxnmq_f32(high_z, points.val[2]);
+    }
+    low = glm::vec3(vminnmvq_f32(low_x), vminnmvq_f32(low_y), vminnmvq_f32(low_z));
+    high = glm::vec3(vmaxnmvq_f32(high_x), vmaxnmvq_f32(high_y), vmaxnmvq_f32(high_z));
+    return i;
+}
+
+static size_t reduce_distance_neon(float const *floats, size_t count, glm::vec3 const &center, float &farthest) {
+    float32x4_t best = vdupq_n_f32(farthest);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4x3_t const points = vld3q_f32(floats + i * 3);
+        float32x4_t const x = vsubq_f32(points.val[0], vdupq_n_f32(center.x));
+        float32x4_t const y = vsubq_f32(points.val[1], vdupq_n_f32(center.y));
+        float32x4_t const z = vsubq_f32(points.val[2], vdupq_n_f32(center.z));
+        best = vmaxnmq_f32(best, vfmaq_f32(vfmaq_f32(vmulq_f32(x, x), y, y), z, z));
+    }
+    farthest = vmaxnmvq_f32(best);
+    return i;
+}
+#endif
+
+/**
+ * @brief Widens low and high to cover the points, vectorized where possible
+ */
+static void reduce_box(glm::vec3 const *points, size_t count, glm::vec3 &low, glm::vec3 &high) {
+    size_t i = 0;
+#if defined(MESH_BOUNDS_X86)
+    i = reduce_box_sse(&points[0].x, count, low, high);
+#elif defined(MESH_BOUNDS_NEON)
+    i = reduce_box_neon(&points[0].x, count, low, high);
+#endif
+    for (; i < count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            // Comparisons with NaN are false, which keeps the bound
+            float const value = points[i][axis];
+            low[axis] = value < low[axis] ? value : low[axis];
+            high[axis] = value > high[axis] ? value : high[axis];
+        }
+    }
+}
+
+/**
+ * @brief Largest squared distance from center to the points
+ */
+static float reduce_distance(glm::vec3 const *points, size_t count, glm::vec3 const &center) {
+    float farthest = 0.0f;
+    size_t i = 0;
+#if defined(MESH_BOUNDS_X86)
+    i = reduce_distance_sse(&points[0].x, count, center, farthest);
+#elif defined(MESH_BOUNDS_NEON)
+    i = reduce_distance_neon(&points[0].x, count, center, farthest);
+#endif
+    for (; i < count; i++) {
+        glm::vec3 const offset = points[i] - center;
+        float const squared = glm::dot(offset, offset);
+        farthest = squared > farthest ? squared : farthest;
+    }
+    return farthest;
+}
+
+#undef MESH_BOUNDS_X86
+#undef MESH_BOUNDS_NEON
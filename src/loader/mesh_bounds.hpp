@@ -0,0 +1,42 @@
+#ifndef MESH_BOUNDS_H_
+#define MESH_BOUNDS_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// Below this many points a single thread is faster than splitting the work
+constexpr size_t BOUNDS_PARALLEL_VERTICES = 1 << 18;
+
+/**
+ * @brief Axis aligned box of a set of points and the radius of the
+ * bounding sphere around its center
+ */
+struct MeshBounds {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+    float radius = 0.0f;
+};
+
+/**
+ * @brief Bounds of a set of points in two vectorized passes
+ *
+ * The first pass reduces the box, the second the farthest distance from its
+ * center, which gives the smallest sphere around that center. Large inputs
+ * split each pass between threads. NaN coordinates are ignored, and no
+ * points give an empty box at the origin.
+ *
+ * @param positions Points to bound, e.g. the unique positions of a mesh
+ * @param bounds Output box and radius
+ * @param thread_count Number of threads, 0 picks one per core for large inputs
+ */
+void calculate_bounds(std::vector<glm::vec3> const &positions, MeshBounds &bounds, unsigned thread_count = 0);
+
+/**
+ * @brief Sets the bounds, size, center and bounding radius of a mesh
+ *
+ * @param bounds Bounds from calculate_bounds
+ * @param mesh Mesh to update
+ */
+void set_mesh_bounds(MeshBounds const &bounds, Mesh &mesh);
+
+#endif  // MESH_BOUNDS_H_
@@ -0,0 +1,322 @@
+#include "mesh_cache.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mapped_file.hpp"
+
+// On-disk layout: header, source path, then positions, indices, meshlets,
+// the LOD table and each LOD's indices at 16 byte aligned offsets so a
+// mapped entry can be used in place
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t source_size;
+    int64_t source_mtime_sec;
+    int64_t source_mtime_nsec;
+    uint64_t path_length;
+    uint64_t positions_offset;
+    uint64_t positions_count;
+    uint64_t indices_offset;
+    uint64_t indices_count;
+    uint64_t faces_count;
+    uint64_t vertices_count;
+    float bounds_min[3];
+    float bounds_max[3];
+    float model_center[3];
+    float model_size;
+    uint32_t optimized;
+    uint64_t meshlets_offset;
+    uint64_t meshlets_count;
+    uint64_t lods_offset;
+    uint64_t lods_count;
+    float bounding_radius;
+    uint32_t padding;
+};
+
+struct MeshCacheLod {
+    uint64_t indices_offset;
+    uint64_t indices_count;
+    float error;
+    uint32_t padding;
+};
+
+static char const MESH_CACHE_MAGIC[8] = {'S', '2', '1', 'M', 'E', 'S', 'H', '\0'};
+
+static std::string canonical_path(std::string const &path);
+static bool stat_source(std::string const &path, MeshCacheHeader &header);
+static uint64_t align_offset(uint64_t offset);
+static bool make_directories(std::string const &path);
+static bool indices_in_range(std::vector<uint32_t> const &indices, size_t vertex_count);
+
+std::string mesh_cache_directory() {
+    char const *dir = getenv("MODEL_VIEWER_CACHE_DIR");
+    if (dir != nullptr && dir[0] != '\0') {
+        return dir;
+    }
+    dir = getenv("XDG_CACHE_HOME");
+    if (dir != nullptr && dir[0] != '\0') {
+        return std::string(dir) + "/3d_model_viewer";
+    }
+    dir = getenv("HOME");
+    if (dir != nullptr && dir[0] != '\0') {
+        return std::string(dir) + "/.cache/3d_model_viewer";
+    }
+    return "";
+}
+
+std::string mesh_cache_path(std::string const &path) {
+    auto const dir = mesh_cache_directory();
+    if (dir.empty()) {
+        return "";
+    }
+
+    // FNV-1a of the path names the entry, the path itself is checked on load
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : canonical_path(path)) {
+        hash = (hash ^ c) * 0x100000001b3ull;
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hash));
+    return dir + "/" + name;
+}
+
+bool load_mesh_cache(std::string const &model_path, Mesh &mesh) {
+    auto const path = canonical_path(model_path);
+    MeshCacheHeader expected;
+    if (!stat_source(path, expected)) {
+        return false;
+    }
+    auto const cache_path = mesh_cache_path(path);
+    struct stat info;
+    if (cache_path.empty() || stat(cache_path.c_str(), &info) != 0) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!open_mapped_file(cache_path.c_str(), file)) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    bool valid = file.size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, file.data, sizeof(header));
+        valid = memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) == 0 &&
+                header.version == MESH_CACHE_VERSION && header.header_size == sizeof(header) &&
+                header.source_size == expected.source_size &&
+                header.source_mtime_sec == expected.source_mtime_sec &&
+                header.source_mtime_nsec == expected.source_mtime_nsec &&
+                header.path_length == path.size() && sizeof(header) + path.size() <= file.size &&
+                memcmp(file.data + sizeof(header), path.data(), path.size()) == 0;
+    }
+    if (valid) {
+        valid = header.positions_count <= file.size / sizeof(glm::vec3) &&
+                header.indices_count <= file.size / sizeof(uint32_t) &&
+                header.positions_offset <= file.size - header.positions_count * sizeof(glm::vec3) &&
+                header.indices_offset <= file.size - header.indices_count * sizeof(uint32_t);
+    }
+    if (valid) {
+        valid = header.meshlets_count <= file.size / sizeof(Meshlet) &&
+                header.meshlets_offset <= file.size - header.meshlets_count * sizeof(Meshlet) &&
+                header.lods_count <= file.size / sizeof(MeshCacheLod) &&
+                header.lods_offset <= file.size - header.lods_count * sizeof(MeshCacheLod);
+    }
+    std::vector<MeshCacheLod> lods(valid ? header.lods_count : 0);
+    for (size_t i = 0; valid && i < lods.size(); i++) {
+        memcpy(&lods[i], file.data + header.lods_offset + i * sizeof(MeshCacheLod), sizeof(MeshCacheLod));
+        valid = lods[i].indices_count <= file.size / sizeof(uint32_t) &&
+                lods[i].indices_offset <= file.size - lods[i].indices_count * sizeof(uint32_t);
+    }
+    if (!valid) {
+        close_mapped_file(file);
+        return false;
+    }
+
+    // Read into a separate mesh, the output stays untouched if the entry is bad
+    Mesh entry;
+    entry.positions.resize(header.positions_count);
+    memcpy(entry.positions.data(), file.data + header.positions_offset,
+           header.positions_count * sizeof(glm::vec3));
+    entry.indices.resize(header.indices_count);
+    memcpy(entry.indices.data(), file.data + header.indices_offset,
+           header.indices_count * sizeof(uint32_t));
+    entry.meshlets.resize(header.meshlets_count);
+    memcpy(entry.meshlets.data(), file.data + header.meshlets_offset, header.meshlets_count * sizeof(Meshlet));
+    entry.lods.resize(lods.size());
+    for (size_t i = 0; i < lods.size(); i++) {
+        entry.lods[i].indices.resize(lods[i].indices_count);
+        memcpy(entry.lods[i].indices.data(), file.data + lods[i].indices_offset,
+               lods[i].indices_count * sizeof(uint32_t));
+        entry.lods[i].error = lods[i].error;
+    }
+    close_mapped_file(file);
+
+    // A corrupt entry must not send the GL, raster or simplify paths out of bounds
+    valid = indices_in_range(entry.indices, entry.positions.size());
+    for (size_t i = 0; valid && i < entry.lods.size(); i++) {
+        valid = indices_in_range(entry.lods[i].indices, entry.positions.size());
+    }
+    for (size_t i = 0; valid && i < entry.meshlets.size(); i++) {
+        Meshlet const &meshlet = entry.meshlets[i];
+        valid = meshlet.first_index <= entry.indices.size() &&
+                meshlet.index_count <= entry.indices.size() - meshlet.first_index;
+    }
+    if (!valid) {
+        return false;
+    }
+
+    entry.faces_count = header.faces_count;
+    entry.vertices_count = header.vertices_count;
+    entry.model_size = header.model_size;
+    entry.bounding_radius = header.bounding_radius;
+    entry.model_center = glm::vec3(header.model_center[0], header.model_center[1], header.model_center[2]);
+    entry.bounds_min = glm::vec3(header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]);
+    entry.bounds_max = glm::vec3(header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]);
+    entry.optimized = header.optimized != 0;
+    mesh = std::move(entry);
+    return true;
+}
+
+bool save_mesh_cache(std::string const &model_path, Mesh const &mesh) {
+    auto const path = canonical_path(model_path);
+    MeshCacheHeader header;
+    if (!stat_source(path, header)) {
+        return false;
+    }
+    auto const cache_path = mesh_cache_path(path);
+    if (cache_path.empty() || !make_directories(mesh_cache_directory())) {
+        return false;
+    }
+
+    memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MESH_CACHE_VERSION;
+    header.header_size = sizeof(header);
+    header.path_length = path.size();
+    header.positions_offset = align_offset(sizeof(header) + path.size());
+    header.positions_count = mesh.positions.size();
+    header.indices_offset = align_offset(header.positions_offset + mesh.positions.size() * sizeof(glm::vec3));
+    header.indices_count = mesh.indices.size();
+    header.faces_count = mesh.faces_count;
+    header.vertices_count = mesh.vertices_count;
+    for (int i = 0; i < 3; i++) {
+        header.bounds_min[i] = mesh.bounds_min[i];
+        header.bounds_max[i] = mesh.bounds_max[i];
+        header.model_center[i] = mesh.model_center[i];
+    }
+    header.model_size = mesh.model_size;
+    header.bounding_radius = mesh.bounding_radius;
+    header.padding = 0;
+    header.optimized = mesh.optimized ? 1 : 0;
+    header.meshlets_offset = align_offset(header.indices_offset + mesh.indices.size() * sizeof(uint32_t));
+    header.meshlets_count = mesh.meshlets.size();
+    header.lods_offset = align_offset(header.meshlets_offset + mesh.meshlets.size() * sizeof(Meshlet));
+    header.lods_count = mesh.lods.size();
+    std::vector<MeshCacheLod> lods(mesh.lods.size());
+    uint64_t lod_end = header.lods_offset + lods.size() * sizeof(MeshCacheLod);
+    for (size_t i = 0; i < lods.size(); i++) {
+        lods[i].indices_offset = align_offset(lod_end);
+        lods[i].indices_count = mesh.lods[i].indices.size();
+        lods[i].error = mesh.lods[i].error;
+        lods[i].padding = 0;
+        lod_end = lods[i].indices_offset + lods[i].indices_count * sizeof(uint32_t);
+    }
+
+    // Write next to the final entry and rename so readers never see half a
+    // file, the temp name is unique so other viewers can write the same entry
+    std::string tmp_path = cache_path + ".XXXXXX";
+    int const fd = mkstemp(&tmp_path[0]);
+    FILE *file = fd < 0 ? nullptr : fdopen(fd, "wb");
+    if (file == nullptr) {
+        printf("There was an error opening file: '%s'\n", tmp_path.c_str());
+        if (fd >= 0) {
+            close(fd);
+            remove(tmp_path.c_str());
+        }
+        return false;
+    }
+
+    static char const padding[16] = {0};
+    uint64_t const path_end = sizeof(header) + path.size();
+    uint64_t const positions_end = header.positions_offset + mesh.positions.size() * sizeof(glm::vec3);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(path.data(), 1, path.size(), file) == path.size() &&
+                   fwrite(padding, 1, header.positions_offset - path_end, file) == header.positions_offset - path_end &&
+                   fwrite(mesh.positions.data(), sizeof(glm::vec3), mesh.positions.size(), file) == mesh.positions.size() &&
+                   fwrite(padding, 1, header.indices_offset - positions_end, file) == header.indices_offset - positions_end &&
+                   fwrite(mesh.indices.data(), sizeof(uint32_t), mesh.indices.size(), file) == mesh.indices.size();
+    uint64_t written_end = header.indices_offset + mesh.indices.size() * sizeof(uint32_t);
+    written = written &&
+              fwrite(padding, 1, header.meshlets_offset - written_end, file) == header.meshlets_offset - written_end &&
+              fwrite(mesh.meshlets.data(), sizeof(Meshlet), mesh.meshlets.size(), file) == mesh.meshlets.size();
+    written_end = header.meshlets_offset + mesh.meshlets.size() * sizeof(Meshlet);
+    written = written && fwrite(padding, 1, header.lods_offset - written_end, file) == header.lods_offset - written_end &&
+              fwrite(lods.data(), sizeof(MeshCacheLod), lods.size(), file) == lods.size();
+    written_end = header.lods_offset + lods.size() * sizeof(MeshCacheLod);
+    for (size_t i = 0; written && i < lods.size(); i++) {
+        auto const &indices = mesh.lods[i].indices;
+        written = fwrite(padding, 1, lods[i].indices_offset - written_end, file) == lods[i].indices_offset - written_end &&
+                  fwrite(indices.data(), sizeof(uint32_t), indices.size(), file) == indices.size();
+        written_end = lods[i].indices_offset + indices.size() * sizeof(uint32_t);
+    }
+    written = fclose(file) == 0 && written;
+
+    if (!written || rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+        printf("There was an error writing file: '%s'\n", cache_path.c_str());
+        remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static bool indices_in_range(std::vector<uint32_t> const &indices, size_t vertex_count) {
+    for (uint32_t const index : indices) {
+        if (index >= vertex_count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string canonical_path(std::string const &path) {
+    char resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved) == nullptr) {
+        return path;
+    }
+    return resolved;
+}
+
+static bool stat_source(std::string const &path, MeshCacheHeader &header) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    memset(&header, 0, sizeof(header));
+    header.source_size = static_cast<uint64_t>(info.st_size);
+    header.source_mtime_sec = static_cast<int64_t>(info.st_mtime);
+#ifdef __APPLE__
+    header.source_mtime_nsec = static_cast<int64_t>(info.st_mtimespec.tv_nsec);
+#else
+    header.source_mtime_nsec = static_cast<int64_t>(info.st_mtim.tv_nsec);
+#endif
+    return true;
+}
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + 15) & ~static_cast<uint64_t>(15);
+}
+
+static bool make_directories(std::string const &path) {
+    for (size_t slash = path.find('/', 1); ; slash = path.find('/', slash + 1)) {
+        auto const dir = path.substr(0, slash);
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (slash == path.npos) {
+            return true;
+        }
+    }
+}
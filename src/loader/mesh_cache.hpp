@@ -0,0 +1,48 @@
+#ifndef MESH_CACHE_H_
+#define MESH_CACHE_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// Bump whenever the on-disk layout or the loaders' output changes
+constexpr uint32_t MESH_CACHE_VERSION = 5;
+
+/**
+ * @brief Directory holding cached meshes
+ *
+ * Uses $MODEL_VIEWER_CACHE_DIR, then $XDG_CACHE_HOME/3d_model_viewer, then
+ * ~/.cache/3d_model_viewer.
+ *
+ * @return Returns an empty string if no directory could be determined
+ */
+std::string mesh_cache_directory();
+
+/**
+ * @brief Path of the cache entry for a model file
+ *
+ * @param path Path to the model file
+ */
+std::string mesh_cache_path(std::string const &path);
+
+/**
+ * @brief Loads a mesh from the cache if the entry matches the model file
+ *
+ * The entry is keyed by path, file size and modification time, and is read
+ * through a single memory mapping.
+ *
+ * @param path Path to the model file
+ * @param mesh Output mesh, untouched on a miss
+ * @return Returns true on a cache hit
+ */
+bool load_mesh_cache(std::string const &path, Mesh &mesh);
+
+/**
+ * @brief Stores a processed mesh in the cache
+ *
+ * @param path Path to the model file the mesh was loaded from
+ * @param mesh Mesh to store
+ * @return Returns false if the entry could not be written
+ */
+bool save_mesh_cache(std::string const &path, Mesh const &mesh);
+
+#endif  // MESH_CACHE_H_
@@ -0,0 +1,112 @@
+#include "mesh_edges.hpp"
+
+#include <algorithm>
+#include <thread>
+#include "../utils/parallel.hpp"
+
+// Never a valid key, the smaller index of an edge is below UINT32_MAX
+static constexpr uint64_t EMPTY_EDGE = ~0ull;
+
+static uint64_t hash_edge(uint64_t key);
+static void collect_edge_keys(std::vector<uint32_t> const &indices, size_t first_triangle, size_t last_triangle,
+                              std::vector<uint64_t> *buckets, size_t bucket_count);
+static void deduplicate_edges(std::vector<std::vector<uint64_t>> const &buckets, size_t bucket, size_t bucket_count,
+                              std::vector<uint32_t> &edges);
+
+void extract_edges(std::vector<uint32_t> const &indices, std::vector<uint32_t> &edges, unsigned thread_count) {
+    edges.clear();
+    size_t const triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+    size_t task_count = thread_count;
+    if (task_count == 0) {
+        task_count = triangle_count < EDGE_PARALLEL_TRIANGLES ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    }
+    task_count = std::min(task_count, triangle_count);
+
+    // Each task sorts the edges of its faces into one bucket per task, equal
+    // edges always hash to the same bucket whichever face they come from
+    std::vector<std::vector<uint64_t>> buckets(task_count * task_count);
+    run_parallel(task_count, [&](size_t task) {
+        size_t const first = triangle_count * task / task_count;
+        size_t const last = triangle_count * (task + 1) / task_count;
+        collect_edge_keys(indices, first, last, buckets.data() + task * task_count, task_count);
+    });
+
+    // Then each task owns one bucket across all tasks
+    std::vector<std::vector<uint32_t>> bucket_edges(task_count);
+    run_parallel(task_count, [&](size_t bucket) {
+        deduplicate_edges(buckets, bucket, task_count, bucket_edges[bucket]);
+    });
+
+    size_t total = 0;
+    for (auto const &bucket : bucket_edges) {
+        total += bucket.size();
+    }
+    edges.reserve(total);
+    for (auto const &bucket : bucket_edges) {
+        edges.insert(edges.end(), bucket.begin(), bucket.end());
+    }
+}
+
+/**
+ * @brief Mixes the bits of an edge key (splitmix64 finalizer)
+ */
+static uint64_t hash_edge(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+static void collect_edge_keys(std::vector<uint32_t> const &indices, size_t first_triangle, size_t last_triangle,
+                              std::vector<uint64_t> *buckets, size_t bucket_count) {
+    for (size_t t = first_triangle; t < last_triangle; t++) {
+        uint32_t const *corners = &indices[3 * t];
+        for (int i = 0; i < 3; i++) {
+            uint32_t const a = corners[i];
+            uint32_t const b = corners[(i + 1) % 3];
+            if (a == b) {
+                continue;
+            }
+            // Both directions of an edge share a key
+            uint64_t const key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+            buckets[(hash_edge(key) >> 32) % bucket_count].push_back(key);
+        }
+    }
+}
+
+static void deduplicate_edges(std::vector<std::vector<uint64_t>> const &buckets, size_t bucket, size_t bucket_count,
+                              std::vector<uint32_t> &edges) {
+    size_t key_count = 0;
+    for (size_t task = 0; task < bucket_count; task++) {
+        key_count += buckets[task * bucket_count + bucket].size();
+    }
+
+    // Open addressing table at most half full, probed with the low hash bits
+    size_t table_size = 16;
+    while (table_size < key_count * 2) {
+        table_size *= 2;
+    }
+    size_t const mask = table_size - 1;
+    std::vector<uint64_t> table(table_size, EMPTY_EDGE);
+
+    for (size_t task = 0; task < bucket_count; task++) {
+        for (uint64_t const key : buckets[task * bucket_count + bucket]) {
+            size_t slot = hash_edge(key) & mask;
+            while (table[slot] != EMPTY_EDGE && table[slot] != key) {
+                slot = (slot + 1) & mask;
+            }
+            if (table[slot] == key) {
+                continue;
+            }
+            // First time seen, kept in index buffer order
+            table[slot] = key;
+            edges.push_back(static_cast<uint32_t>(key >> 32));
+            edges.push_back(static_cast<uint32_t>(key));
+        }
+    }
+}
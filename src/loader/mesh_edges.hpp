@@ -0,0 +1,24 @@
+#ifndef MESH_EDGES_H_
+#define MESH_EDGES_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// Below this many triangles a single thread is faster than splitting the work
+constexpr size_t EDGE_PARALLEL_TRIANGLES = 1 << 16;
+
+/**
+ * @brief Builds the set of unique edges of a triangle list
+ *
+ * Every edge shared by several faces is kept once, so a closed mesh gives
+ * about 1.5 edges per triangle instead of 3 segments. Edge keys are split
+ * into buckets by hash, which lets large meshes deduplicate each bucket on
+ * its own thread.
+ *
+ * @param indices Three indices per face
+ * @param edges Output pairs of indices, ready to draw as GL_LINES
+ * @param thread_count Number of threads, 0 picks one per core for large meshes
+ */
+void extract_edges(std::vector<uint32_t> const &indices, std::vector<uint32_t> &edges, unsigned thread_count = 0);
+
+#endif  // MESH_EDGES_H_
@@ -0,0 +1,352 @@
+#include "mesh_generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "loader.hpp"
+#include "mesh_bounds.hpp"
+#include "pure_model.hpp"
+#include "../utils/parallel.hpp"
+#include "../utils/utils.hpp"
+
+// Octaves of value noise summed into the displacement
+constexpr int NOISE_OCTAVES = 4;
+// Lattice cells across the unit size of a shape for the first octave
+constexpr float NOISE_FREQUENCY = 2.0f;
+// Vertices a thread generates at least
+constexpr size_t GENERATOR_MIN_CHUNK = 4096;
+constexpr float PI = 3.14159265358979f;
+
+static size_t shape_vertex_count(GeneratedShape shape, size_t triangles);
+static void sphere_size(size_t triangles, size_t &segments, size_t &rings);
+static void grid_size(size_t triangles, size_t &columns, size_t &rows);
+static void generate_sphere(GeneratorOptions const &options, size_t triangles, Mesh &mesh);
+static void generate_terrain(GeneratorOptions const &options, size_t triangles, Mesh &mesh);
+static void generate_soup(GeneratorOptions const &options, size_t triangles, Mesh &mesh);
+template <typename Function>
+static void for_each_parallel(size_t count, Function const &function);
+static uint64_t mix_bits(uint64_t value);
+static float random_unit(uint64_t seed, uint64_t index);
+static float value_noise(uint64_t seed, glm::vec3 const &point);
+static float fractal_noise(uint64_t seed, glm::vec3 const &point);
+
+bool parse_generated_shape(std::string const &name, GeneratedShape &shape) {
+    if (name == "sphere") {
+        shape = SHAPE_SPHERE;
+    } else if (name == "terrain") {
+        shape = SHAPE_TERRAIN;
+    } else if (name == "soup") {
+        shape = SHAPE_SOUP;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void generate_mesh(GeneratorOptions const &options, Mesh &mesh) {
+    mesh = Mesh();
+    size_t const triangles = std::max<size_t>(1, options.triangles);
+    size_t built = triangles;
+    if (options.max_vertices > 0 && shape_vertex_count(options.shape, triangles) > options.max_vertices) {
+        // Largest count within the budget, vertex counts grow with the triangles
+        size_t low = 1, high = triangles;
+        while (low + 1 < high) {
+            size_t const middle = low + (high - low) / 2;
+            if (shape_vertex_count(options.shape, middle) <= options.max_vertices) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        built = low;
+    }
+
+    switch (options.shape) {
+        case SHAPE_SPHERE:
+            generate_sphere(options, built, mesh);
+            break;
+        case SHAPE_TERRAIN:
+            generate_terrain(options, built, mesh);
+            break;
+        case SHAPE_SOUP:
+            generate_soup(options, built, mesh);
+            break;
+    }
+    if (built < triangles) {
+        size_t const built_indices = mesh.indices.size();
+        mesh.indices.resize(triangles * 3);
+        // Each copy turns its faces' corners, keeping the winding, so the
+        // first two faces never recur as the 0 1 2 1 .model block marker
+        for (size_t i = built_indices; i < mesh.indices.size(); i++) {
+            size_t const turn = (i / built_indices) % 2 + 1;
+            size_t const corner = i % 3;
+            mesh.indices[i] = mesh.indices[i % built_indices - corner + (corner + turn) % 3];
+        }
+    }
+
+    mesh.faces_count = mesh.indices.size() / 3;
+    mesh.vertices_count = mesh.positions.size();
+    MeshBounds bounds;
+    calculate_bounds(mesh.positions, bounds);
+    set_mesh_bounds(bounds, mesh);
+}
+
+bool parse_generator_args(int argc, char **argv, GeneratorOptions &options, std::string &path) {
+    if (argc < 3) {
+        printf("Missing the shape, triangle count or output path\n");
+        return false;
+    }
+    if (!parse_generated_shape(argv[0], options.shape)) {
+        printf("Unknown shape: '%s'\n", argv[0]);
+        return false;
+    }
+    char *end = nullptr;
+    options.triangles = static_cast<size_t>(strtoull(argv[1], &end, 10));
+    if (*end != '\0' || options.triangles == 0) {
+        printf("Invalid triangle count: '%s'\n", argv[1]);
+        return false;
+    }
+    path = argv[2];
+    for (int i = 3; i < argc; i++) {
+        std::string const arg = argv[i];
+        bool const has_value = i + 1 < argc;
+        if (arg == "--seed" && has_value) {
+            options.seed = strtoull(argv[++i], &end, 10);
+            if (*end != '\0') {
+                printf("Invalid seed: '%s'\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--noise" && has_value) {
+            options.noise = strtof(argv[++i], &end);
+            if (*end != '\0' || options.noise < 0.0f) {
+                printf("Invalid noise: '%s'\n", argv[i]);
+                return false;
+            }
+        } else {
+            printf("Unknown option: '%s'\n", arg.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool write_generated_mesh(std::string const &path, GeneratorOptions const &options) {
+    auto const start = std::chrono::steady_clock::now();
+    std::string const file_ext = get_file_extension(path);
+    GeneratorOptions shape_options = options;
+    if (file_ext == "model") {
+        size_t budget = options.max_vertices == 0 ? PURE_MAX_VERTICES : std::min(options.max_vertices, PURE_MAX_VERTICES);
+        // The index block has to open with two faces sharing a vertex, a soup
+        // shares none so at least its first face is repeated
+        if (options.shape == SHAPE_SOUP) {
+            budget = std::min(budget, std::max<size_t>(3, 3 * (options.triangles - 1)));
+        }
+        shape_options.max_vertices = budget;
+    } else if (file_ext != "obj") {
+        printf("Cant write file of type: %s\n", file_ext.c_str());
+        return false;
+    }
+
+    Mesh mesh;
+    generate_mesh(shape_options, mesh);
+    bool const saved = file_ext == "model" ? save_pure_model(path, mesh) : save_obj(path, mesh);
+    if (saved) {
+        double const ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        printf("Wrote %s: %zu triangles, %zu vertices in %.1f ms\n", path.c_str(), mesh.faces_count,
+               mesh.vertices_count, ms);
+    }
+    return saved;
+}
+
+static size_t shape_vertex_count(GeneratedShape shape, size_t triangles) {
+    size_t first = 0, second = 0;
+    switch (shape) {
+        case SHAPE_SPHERE:
+            sphere_size(triangles, first, second);
+            return 2 + first * second;
+        case SHAPE_TERRAIN:
+            grid_size(triangles, first, second);
+            return first * second;
+        case SHAPE_SOUP:
+            return triangles * 3;
+    }
+    return 0;
+}
+
+/**
+ * @brief Segments around and rings of vertices between the poles, for at
+ * least the given number of triangles
+ */
+static void sphere_size(size_t triangles, size_t &segments, size_t &rings) {
+    segments = std::max<size_t>(3, static_cast<size_t>(std::llround(std::sqrt(static_cast<double>(triangles)))));
+    // Two fans of one triangle per segment, two per segment between rings
+    rings = std::max<size_t>(1, (triangles + 2 * segments - 1) / (2 * segments));
+}
+
+/**
+ * @brief Vertex columns and rows of a near square grid with enough quads
+ */
+static void grid_size(size_t triangles, size_t &columns, size_t &rows) {
+    size_t const quads = (triangles + 1) / 2;
+    columns = std::max<size_t>(3, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(quads)))) + 1);
+    rows = std::max<size_t>(2, (quads + columns - 2) / (columns - 1) + 1);
+}
+
+static void generate_sphere(GeneratorOptions const &options, size_t triangles, Mesh &mesh) {
+    size_t segments = 0, rings = 0;
+    sphere_size(triangles, segments, rings);
+    // Poles first and last, then the rings from the top
+    mesh.positions.resize(2 + rings * segments);
+    for_each_parallel(mesh.positions.size(), [&](size_t i) {
+        glm::vec3 direction(0.0f, i == 0 ? 1.0f : -1.0f, 0.0f);
+        if (i > 0 && i <= rings * segments) {
+            float const theta = PI * ((i - 1) / segments + 1) / (rings + 1);
+            float const phi = 2.0f * PI * ((i - 1) % segments) / segments;
+            direction = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        }
+        float const radius = 1.0f + options.noise * fractal_noise(options.seed, direction * NOISE_FREQUENCY);
+        mesh.positions[i] = direction * radius;
+    });
+
+    auto ring_vertex = [segments](size_t ring, size_t segment) {
+        return static_cast<uint32_t>(1 + ring * segments + segment % segments);
+    };
+    uint32_t const bottom = static_cast<uint32_t>(mesh.positions.size() - 1);
+    mesh.indices.reserve(2 * segments * rings * 3);
+    for (size_t segment = 0; segment < segments; segment++) {
+        uint32_t const fan[3] = {0, ring_vertex(0, segment + 1), ring_vertex(0, segment)};
+        mesh.indices.insert(mesh.indices.end(), fan, fan + 3);
+    }
+    for (size_t ring = 0; ring + 1 < rings; ring++) {
+        for (size_t segment = 0; segment < segments; segment++) {
+            uint32_t const a = ring_vertex(ring, segment), b = ring_vertex(ring, segment + 1);
+            uint32_t const c = ring_vertex(ring + 1, segment), d = ring_vertex(ring + 1, segment + 1);
+            uint32_t const quad[6] = {a, b, c, b, d, c};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    for (size_t segment = 0; segment < segments; segment++) {
+        uint32_t const fan[3] = {ring_vertex(rings - 1, segment), ring_vertex(rings - 1, segment + 1), bottom};
+        mesh.indices.insert(mesh.indices.end(), fan, fan + 3);
+    }
+}
+
+static void generate_terrain(GeneratorOptions const &options, size_t triangles, Mesh &mesh) {
+    size_t columns = 0, rows = 0;
+    grid_size(triangles, columns, rows);
+    mesh.positions.resize(columns * rows);
+    for_each_parallel(mesh.positions.size(), [&](size_t i) {
+        float const x = 2.0f * (i % columns) / (columns - 1) - 1.0f;
+        float const z = 2.0f * (i / columns) / (rows - 1) - 1.0f;
+        float const y = options.noise * fractal_noise(options.seed, glm::vec3(x, 0.0f, z) * NOISE_FREQUENCY);
+        mesh.positions[i] = glm::vec3(x, y, z);
+    });
+
+    // Row by row, two counter-clockwise triangles per quad facing +y, stopping at the exact count
+    mesh.indices.reserve(triangles * 3);
+    for (size_t quad = 0; mesh.indices.size() < triangles * 3; quad++) {
+        uint32_t const a = static_cast<uint32_t>(quad / (columns - 1) * columns + quad % (columns - 1));
+        uint32_t const b = a + 1, c = a + static_cast<uint32_t>(columns), d = c + 1;
+        uint32_t const quad_indices[6] = {a, c, b, b, c, d};
+        size_t const count = std::min<size_t>(6, triangles * 3 - mesh.indices.size());
+        mesh.indices.insert(mesh.indices.end(), quad_indices, quad_indices + count);
+    }
+}
+
+static void generate_soup(GeneratorOptions const &options, size_t triangles, Mesh &mesh) {
+    // Edges shrink with the count so the soup keeps about the same coverage
+    float const size = 1.0f / std::cbrt(static_cast<float>(triangles));
+    mesh.positions.resize(triangles * 3);
+    for_each_parallel(triangles, [&](size_t face) {
+        uint64_t const key = face * 12;
+        glm::vec3 center;
+        for (int axis = 0; axis < 3; axis++) {
+            center[axis] = (1.0f - size) * (2.0f * random_unit(options.seed, key + axis) - 1.0f);
+        }
+        for (int corner = 0; corner < 3; corner++) {
+            glm::vec3 &position = mesh.positions[face * 3 + corner];
+            for (int axis = 0; axis < 3; axis++) {
+                position[axis] = center[axis] + size * (2.0f * random_unit(options.seed, key + 3 + corner * 3 + axis) - 1.0f);
+            }
+        }
+    });
+    mesh.indices.resize(triangles * 3);
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        mesh.indices[i] = static_cast<uint32_t>(i);
+    }
+}
+
+/**
+ * @brief Calls function for every index in [0, count) from several threads
+ */
+template <typename Function>
+static void for_each_parallel(size_t count, Function const &function) {
+    size_t const thread_count = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                                 count / GENERATOR_MIN_CHUNK + 1);
+    run_parallel(thread_count, [&](size_t thread) {
+        for (size_t i = count * thread / thread_count; i < count * (thread + 1) / thread_count; i++) {
+            function(i);
+        }
+    });
+}
+
+/**
+ * @brief splitmix64 finalizer, every input bit affects every output bit
+ */
+static uint64_t mix_bits(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Random number in [0, 1) that only depends on the seed and index,
+ * so threads can generate any part of a mesh independently
+ */
+static float random_unit(uint64_t seed, uint64_t index) {
+    return static_cast<float>(mix_bits(mix_bits(seed) ^ index) >> 40) * (1.0f / (1 << 24));
+}
+
+/**
+ * @brief Smoothly interpolated random values in [-1, 1] on an integer lattice
+ */
+static float value_noise(uint64_t seed, glm::vec3 const &point) {
+    float weights[3];
+    int64_t cell[3];
+    for (int axis = 0; axis < 3; axis++) {
+        float const floor = std::floor(point[axis]);
+        float const t = point[axis] - floor;
+        weights[axis] = t * t * (3.0f - 2.0f * t);
+        cell[axis] = static_cast<int64_t>(floor);
+    }
+    // Corners blended along x, then y, then z
+    float values[8];
+    for (int corner = 0; corner < 8; corner++) {
+        uint64_t const x = static_cast<uint64_t>(cell[0] + (corner & 1));
+        uint64_t const y = static_cast<uint64_t>(cell[1] + ((corner >> 1) & 1));
+        uint64_t const z = static_cast<uint64_t>(cell[2] + (corner >> 2));
+        uint64_t const key = x * 0x9E3779B97F4A7C15ull ^ y * 0xC2B2AE3D27D4EB4Full ^ z * 0x165667B19E3779F9ull;
+        values[corner] = 2.0f * random_unit(seed, key) - 1.0f;
+    }
+    for (int axis = 0, count = 8; axis < 3; axis++, count /= 2) {
+        for (int i = 0; i < count / 2; i++) {
+            values[i] = values[2 * i] + (values[2 * i + 1] - values[2 * i]) * weights[axis];
+        }
+    }
+    return values[0];
+}
+
+/**
+ * @brief Octaves of value noise at doubling frequencies, in [-1, 1]
+ */
+static float fractal_noise(uint64_t seed, glm::vec3 const &point) {
+    float sum = 0.0f, amplitude = 1.0f, total = 0.0f;
+    for (int octave = 0; octave < NOISE_OCTAVES; octave++) {
+        sum += amplitude * value_noise(seed + octave, point * static_cast<float>(1 << octave));
+        total += amplitude;
+        amplitude *= 0.5f;
+    }
+    return sum / total;
+}
@@ -0,0 +1,75 @@
+#ifndef MESH_GENERATOR_H_
+#define MESH_GENERATOR_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+/**
+ * @brief Kinds of synthetic meshes
+ */
+enum GeneratedShape {
+    SHAPE_SPHERE,   // closed UV sphere with a noisy radius
+    SHAPE_TERRAIN,  // height field over a square grid
+    SHAPE_SOUP,     // small unconnected triangles scattered in a cube
+};
+
+struct GeneratorOptions {
+    GeneratedShape shape = SHAPE_SPHERE;
+    size_t triangles = 0;
+    uint64_t seed = 1;
+    // Displacement amplitude, relative to the unit size of every shape
+    float noise = 0.1f;
+    // Most vertices to use, 0 for no limit. Past it a smaller mesh is built
+    // and its faces repeat until the triangle count is reached.
+    size_t max_vertices = 0;
+};
+
+/**
+ * @brief Reads a shape name: sphere, terrain or soup
+ *
+ * @param name Shape name
+ * @param shape Output shape
+ * @return Returns false for an unknown name
+ */
+bool parse_generated_shape(std::string const &name, GeneratedShape &shape);
+
+/**
+ * @brief Builds a synthetic mesh, the same options always give the same mesh
+ *
+ * Terrains and soups get exactly the asked triangle count, spheres the
+ * smallest tessellation with at least that many. Positions stay within
+ * [-1 - noise, 1 + noise] on every axis. Faces are counter-clockwise seen
+ * from outside, or from +y for terrains.
+ *
+ * @param options Shape, size and seed
+ * @param mesh Output mesh with positions, indices, counts and bounds
+ */
+void generate_mesh(GeneratorOptions const &options, Mesh &mesh);
+
+/**
+ * @brief Reads the arguments following --generate
+ *
+ * Usage: <sphere|terrain|soup> <triangles> <output> [--seed N] [--noise X]
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments after --generate
+ * @param options Output options
+ * @param path Output file path
+ * @return Returns false and prints the problem if the arguments are invalid
+ */
+bool parse_generator_args(int argc, char **argv, GeneratorOptions &options, std::string &path);
+
+/**
+ * @brief Generates a mesh and writes it as OBJ or PureParts .model
+ *
+ * The format comes from the extension. A .model path needs a LOD tag like
+ * when loading, and its mesh is limited to the 16 bit index range with
+ * repeated faces.
+ *
+ * @param path Output path
+ * @param options Shape, size and seed
+ * @return Returns false and prints the problem if the file can't be written
+ */
+bool write_generated_mesh(std::string const &path, GeneratorOptions const &options);
+
+#endif  // MESH_GENERATOR_H_
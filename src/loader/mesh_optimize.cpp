@@ -0,0 +1,264 @@
+#include "mesh_optimize.hpp"
+
+#include <algorithm>
+#include "half_float.hpp"
+
+// Smallest run of triangles the overdraw pass may move as a unit, cutting
+// at every dead end would make reordering cost too many cache misses
+constexpr size_t MIN_CLUSTER_TRIANGLES = 256;
+
+// Triangles around each vertex, in compressed row form
+struct VertexAdjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+static void build_adjacency(std::vector<uint32_t> const &indices, size_t vertex_count, VertexAdjacency &adjacency);
+static int64_t next_fanning_vertex(std::vector<uint32_t> const &candidates, std::vector<uint32_t> const &live,
+                                   std::vector<size_t> const &stamps, size_t time, unsigned cache_size);
+static int64_t skip_dead_end(std::vector<uint32_t> &dead_ends, std::vector<uint32_t> const &live, size_t &cursor);
+static glm::vec3 mesh_position(Mesh const &mesh, uint32_t index);
+
+float compute_acmr(std::vector<uint32_t> const &indices, size_t vertex_count, unsigned cache_size) {
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+    // Miss number each vertex entered the cache at, 0 if never loaded
+    std::vector<size_t> stamps(vertex_count, 0);
+    size_t misses = 0;
+    for (auto index : indices) {
+        if (stamps[index] == 0 || misses - stamps[index] >= cache_size) {
+            misses++;
+            stamps[index] = misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count, unsigned cache_size,
+                           std::vector<size_t> *clusters) {
+    size_t const triangle_count = indices.size() / 3;
+    if (clusters != nullptr) {
+        clusters->clear();
+    }
+    if (triangle_count == 0) {
+        return;
+    }
+
+    VertexAdjacency adjacency;
+    build_adjacency(indices, vertex_count, adjacency);
+    std::vector<uint32_t> live(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<size_t> stamps(vertex_count, 0);
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> dead_ends;
+    std::vector<uint32_t> candidates;
+    size_t time = cache_size + 1;
+    size_t cursor = 0;
+
+    int64_t fanning = skip_dead_end(dead_ends, live, cursor);
+    bool cache_broken = true;
+    while (fanning >= 0) {
+        size_t const emitted_count = output.size() / 3;
+        if (cache_broken && clusters != nullptr &&
+            (clusters->empty() || emitted_count - clusters->back() >= MIN_CLUSTER_TRIANGLES)) {
+            clusters->push_back(emitted_count);
+        }
+
+        // Emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (uint32_t i = adjacency.offsets[fanning]; i < adjacency.offsets[fanning + 1]; i++) {
+            uint32_t const triangle = adjacency.triangles[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t const v = indices[3 * triangle + corner];
+                output.push_back(v);
+                dead_ends.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - stamps[v] > cache_size) {
+                    stamps[v] = time++;
+                }
+            }
+        }
+
+        fanning = next_fanning_vertex(candidates, live, stamps, time, cache_size);
+        cache_broken = fanning < 0;
+        if (cache_broken) {
+            fanning = skip_dead_end(dead_ends, live, cursor);
+        }
+    }
+    indices.swap(output);
+}
+
+void optimize_overdraw(Mesh &mesh, std::vector<size_t> const &clusters) {
+    size_t const triangle_count = mesh.indices.size() / 3;
+    if (clusters.size() < 2) {
+        return;
+    }
+
+    glm::vec3 mesh_center(0.0f);
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    for (size_t v = 0; v < vertex_count; v++) {
+        mesh_center += mesh_position(mesh, static_cast<uint32_t>(v));
+    }
+    mesh_center /= static_cast<float>(vertex_count);
+
+    // Clusters facing away from the center occlude the rest, draw them first
+    std::vector<std::pair<float, size_t>> order(clusters.size());
+    for (size_t c = 0; c < clusters.size(); c++) {
+        size_t const end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+        glm::vec3 center(0.0f), normal(0.0f);
+        for (size_t t = clusters[c]; t < end; t++) {
+            glm::vec3 const a = mesh_position(mesh, mesh.indices[3 * t + 0]);
+            glm::vec3 const b = mesh_position(mesh, mesh.indices[3 * t + 1]);
+            glm::vec3 const c2 = mesh_position(mesh, mesh.indices[3 * t + 2]);
+            center += a + b + c2;
+            // Not normalized, so bigger triangles weigh more
+            normal += glm::cross(b - a, c2 - a);
+        }
+        center /= static_cast<float>(3 * (end - clusters[c]));
+        float const length = glm::length(normal);
+        float const potential = length > 0.0f ? glm::dot(center - mesh_center, normal / length) : 0.0f;
+        order[c] = std::make_pair(-potential, c);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [](std::pair<float, size_t> const &a, std::pair<float, size_t> const &b) {
+                         return a.first < b.first;
+                     });
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(mesh.indices.size());
+    for (auto const &entry : order) {
+        size_t const c = entry.second;
+        size_t const end = c + 1 < clusters.size() ? clusters[c + 1] : triangle_count;
+        sorted.insert(sorted.end(), mesh.indices.begin() + 3 * clusters[c], mesh.indices.begin() + 3 * end);
+    }
+    mesh.indices.swap(sorted);
+}
+
+void optimize_vertex_fetch(Mesh &mesh) {
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    bool const half = mesh.positions.empty();
+    std::vector<uint32_t> remap(vertex_count, UINT32_MAX);
+    std::vector<glm::vec3> positions;
+    std::vector<glm::u16vec3> half_positions;
+    uint32_t next = 0;
+    for (auto &index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = next++;
+            if (half) {
+                half_positions.push_back(mesh.half_positions[index]);
+            } else {
+                positions.push_back(mesh.positions[index]);
+            }
+        }
+        index = remap[index];
+    }
+    // Levels only use vertices the full mesh uses too
+    for (auto &lod : mesh.lods) {
+        for (auto &index : lod.indices) {
+            index = remap[index];
+        }
+    }
+    if (half) {
+        mesh.half_positions.swap(half_positions);
+    } else {
+        mesh.positions.swap(positions);
+    }
+}
+
+void optimize_mesh(Mesh &mesh, MeshOptimizeStats *stats) {
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    if (stats != nullptr) {
+        stats->acmr_before = compute_acmr(mesh.indices, vertex_count);
+    }
+
+    std::vector<size_t> clusters;
+    optimize_vertex_cache(mesh.indices, vertex_count, VERTEX_CACHE_SIZE, &clusters);
+    optimize_overdraw(mesh, clusters);
+    for (auto &lod : mesh.lods) {
+        optimize_vertex_cache(lod.indices, vertex_count);
+    }
+    optimize_vertex_fetch(mesh);
+    mesh.optimized = true;
+    mesh.meshlets.clear();
+
+    if (stats != nullptr) {
+        stats->acmr_after = compute_acmr(mesh.indices, mesh_vertex_count(mesh));
+    }
+}
+
+static void build_adjacency(std::vector<uint32_t> const &indices, size_t vertex_count, VertexAdjacency &adjacency) {
+    adjacency.offsets.assign(vertex_count + 1, 0);
+    for (auto index : indices) {
+        adjacency.offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indices.size());
+    std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+        adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+/**
+ * @brief Picks the next vertex to fan around among the ones just emitted
+ *
+ * Prefers the vertex that entered the cache longest ago, as long as its
+ * remaining triangles would still find it there.
+ */
+static int64_t next_fanning_vertex(std::vector<uint32_t> const &candidates, std::vector<uint32_t> const &live,
+                                   std::vector<size_t> const &stamps, size_t time, unsigned cache_size) {
+    int64_t best = -1;
+    int64_t best_priority = -1;
+    for (auto v : candidates) {
+        if (live[v] == 0) {
+            continue;
+        }
+        int64_t priority = 0;
+        if (time - stamps[v] + 2 * live[v] <= cache_size) {
+            priority = static_cast<int64_t>(time - stamps[v]);
+        }
+        if (priority > best_priority) {
+            best_priority = priority;
+            best = v;
+        }
+    }
+    return best;
+}
+
+static int64_t skip_dead_end(std::vector<uint32_t> &dead_ends, std::vector<uint32_t> const &live, size_t &cursor) {
+    while (!dead_ends.empty()) {
+        uint32_t const v = dead_ends.back();
+        dead_ends.pop_back();
+        if (live[v] > 0) {
+            return v;
+        }
+    }
+    for (; cursor < live.size(); cursor++) {
+        if (live[cursor] > 0) {
+            return static_cast<int64_t>(cursor);
+        }
+    }
+    return -1;
+}
+
+static glm::vec3 mesh_position(Mesh const &mesh, uint32_t index) {
+    if (!mesh.positions.empty()) {
+        return mesh.positions[index];
+    }
+    glm::u16vec3 const &half = mesh.half_positions[index];
+    return glm::vec3(convert_float16_to_float32(half.x), convert_float16_to_float32(half.y),
+                     convert_float16_to_float32(half.z));
+}
@@ -0,0 +1,72 @@
+#ifndef MESH_OPTIMIZE_H_
+#define MESH_OPTIMIZE_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// FIFO size used for ACMR and triangle ordering, typical of current GPUs
+constexpr unsigned VERTEX_CACHE_SIZE = 16;
+
+struct MeshOptimizeStats {
+    float acmr_before = 0.0f;
+    float acmr_after = 0.0f;
+};
+
+/**
+ * @brief Average cache miss ratio: vertex shader runs per triangle
+ *
+ * Simulates a FIFO post-transform cache. 3 is the worst case, around 0.6 is
+ * typical of a well ordered mesh.
+ *
+ * @param indices Triangle list indices
+ * @param vertex_count Number of vertices the indices refer to
+ * @param cache_size Number of cache entries
+ */
+float compute_acmr(std::vector<uint32_t> const &indices, size_t vertex_count,
+                   unsigned cache_size = VERTEX_CACHE_SIZE);
+
+/**
+ * @brief Reorders triangles for post-transform vertex cache hits (Tipsify)
+ *
+ * Triangles keep their winding. Also fills the points where the order breaks
+ * the cache, which the overdraw pass uses as cluster boundaries. Clusters are
+ * at least a few hundred triangles long.
+ *
+ * @param indices Triangle list indices, reordered in place
+ * @param vertex_count Number of vertices the indices refer to
+ * @param cache_size Number of cache entries to optimize for
+ * @param clusters Optional output, first triangle of each cluster
+ */
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count,
+                           unsigned cache_size = VERTEX_CACHE_SIZE, std::vector<size_t> *clusters = nullptr);
+
+/**
+ * @brief Sorts triangle clusters so outward facing ones are drawn first
+ *
+ * @param mesh Mesh whose indices are reordered
+ * @param clusters First triangle of each cluster, from optimize_vertex_cache
+ */
+void optimize_overdraw(Mesh &mesh, std::vector<size_t> const &clusters);
+
+/**
+ * @brief Renumbers vertices in the order the indices first use them
+ *
+ * Vertices no face refers to are dropped. Indices of mesh.lods are remapped
+ * along with the full mesh.
+ *
+ * @param mesh Mesh whose positions and indices are rewritten
+ */
+void optimize_vertex_fetch(Mesh &mesh);
+
+/**
+ * @brief Runs the cache, overdraw and fetch passes in that order
+ *
+ * Levels in mesh.lods get the cache pass too. Meshlets no longer match the
+ * new face order and are cleared.
+ *
+ * @param mesh Mesh to optimize in place
+ * @param stats Optional output ACMR before and after
+ */
+void optimize_mesh(Mesh &mesh, MeshOptimizeStats *stats = nullptr);
+
+#endif  // MESH_OPTIMIZE_H_
@@ -0,0 +1,336 @@
+#include "mesh_simplify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "half_float.hpp"
+
+// Borders are held in place by planes through them, this much stiffer than faces
+constexpr double BORDER_WEIGHT = 10.0;
+
+// Symmetric 4x4 error matrix stored as its upper triangle, plus the summed
+// weights so an error can be turned back into a distance
+struct Quadric {
+    double a[10];
+    double weight;
+};
+
+struct Collapse {
+    uint32_t from;
+    uint32_t to;
+    double cost;
+};
+
+// Simplification state kept between levels so errors keep accumulating
+struct Simplifier {
+    std::vector<glm::vec3> const *positions;
+    std::vector<Quadric> quadrics;
+    float error;
+};
+
+static void init_simplifier(Simplifier &simplifier, std::vector<glm::vec3> const &positions,
+                            std::vector<uint32_t> const &indices);
+static void simplify_to(Simplifier &simplifier, std::vector<uint32_t> &indices, size_t target_triangles);
+static size_t collapse_pass(Simplifier &simplifier, std::vector<uint32_t> &indices, size_t target_triangles);
+static bool collapse_flips(std::vector<glm::vec3> const &positions, std::vector<uint32_t> const &indices,
+                           std::vector<uint32_t> const &offsets, std::vector<uint32_t> const &triangles,
+                           uint32_t from, uint32_t to);
+static void add_plane(Quadric &quadric, glm::dvec3 const &normal, double distance, double weight);
+static void add_quadric(Quadric &quadric, Quadric const &other);
+static double evaluate_quadric(Quadric const &quadric, glm::vec3 const &point);
+
+float simplify_indices(std::vector<glm::vec3> const &positions, std::vector<uint32_t> &indices,
+                       size_t target_triangles) {
+    Simplifier simplifier;
+    init_simplifier(simplifier, positions, indices);
+    simplify_to(simplifier, indices, target_triangles);
+    return simplifier.error;
+}
+
+void build_mesh_lods(Mesh &mesh) {
+    mesh.lods.clear();
+    if (mesh.indices.empty()) {
+        return;
+    }
+    std::vector<glm::vec3> decoded;
+    if (mesh.positions.empty() && !mesh.half_positions.empty()) {
+        decoded.resize(mesh.half_positions.size());
+        convert_float16_to_float32(&mesh.half_positions[0].x, &decoded[0].x, decoded.size() * 3);
+    }
+    std::vector<glm::vec3> const &positions = mesh.positions.empty() ? decoded : mesh.positions;
+
+    Simplifier simplifier;
+    init_simplifier(simplifier, positions, mesh.indices);
+    std::vector<uint32_t> indices = mesh.indices;
+    while (mesh.lods.size() < MAX_MESH_LODS) {
+        size_t const triangles = indices.size() / 3;
+        size_t const target = static_cast<size_t>(triangles * LOD_REDUCTION);
+        if (target < LOD_MIN_TRIANGLES) {
+            break;
+        }
+        simplify_to(simplifier, indices, target);
+        // Not worth a level if the mesh barely got smaller
+        if (indices.size() / 3 > triangles - (triangles - target) / 2) {
+            break;
+        }
+        MeshLod lod;
+        lod.indices = indices;
+        lod.error = simplifier.error;
+        mesh.lods.push_back(lod);
+    }
+}
+
+size_t select_mesh_lod(Mesh const &mesh, float view_distance, float fov, float viewport_height,
+                       float pixel_error) {
+    float const distance = std::max(view_distance - mesh.model_size * 0.5f, 1e-4f);
+    // Model units covered by one pixel at that distance
+    float const pixel_size = 2.0f * distance * std::tan(glm::radians(fov) * 0.5f) / viewport_height;
+    size_t selected = 0;
+    for (size_t i = 0; i < mesh.lods.size(); i++) {
+        if (mesh.lods[i].error > pixel_error * pixel_size) {
+            break;
+        }
+        selected = i + 1;
+    }
+    return selected;
+}
+
+uint32_t mesh_lod_first_face(Mesh const &mesh, size_t lod) {
+    size_t faces = 0;
+    for (size_t level = 0; level < lod && level <= mesh.lods.size(); level++) {
+        faces += (level == 0 ? mesh.indices.size() : mesh.lods[level - 1].indices.size()) / 3;
+    }
+    return static_cast<uint32_t>(faces);
+}
+
+static void init_simplifier(Simplifier &simplifier, std::vector<glm::vec3> const &positions,
+                            std::vector<uint32_t> const &indices) {
+    simplifier.positions = &positions;
+    simplifier.error = 0.0f;
+    Quadric zero = {};
+    simplifier.quadrics.assign(positions.size(), zero);
+
+    // Edges as (smaller vertex, larger vertex, triangle) to find borders
+    std::vector<std::array<uint32_t, 3>> edges;
+    edges.reserve(indices.size());
+    for (size_t t = 0; t < indices.size() / 3; t++) {
+        glm::dvec3 const a(positions[indices[3 * t + 0]]);
+        glm::dvec3 const b(positions[indices[3 * t + 1]]);
+        glm::dvec3 const c(positions[indices[3 * t + 2]]);
+        glm::dvec3 normal = glm::cross(b - a, c - a);
+        double const length = glm::length(normal);
+        if (length > 0.0) {
+            normal /= length;
+            for (int i = 0; i < 3; i++) {
+                add_plane(simplifier.quadrics[indices[3 * t + i]], normal, -glm::dot(normal, a), length * 0.5);
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            uint32_t const v0 = indices[3 * t + i];
+            uint32_t const v1 = indices[3 * t + (i + 1) % 3];
+            std::array<uint32_t, 3> edge = {{std::min(v0, v1), std::max(v0, v1), static_cast<uint32_t>(t)}};
+            edges.push_back(edge);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size(); i++) {
+        bool const shared = (i > 0 && edges[i - 1][0] == edges[i][0] && edges[i - 1][1] == edges[i][1]) ||
+                            (i + 1 < edges.size() && edges[i + 1][0] == edges[i][0] && edges[i + 1][1] == edges[i][1]);
+        if (shared) {
+            continue;
+        }
+        size_t const t = edges[i][2];
+        glm::dvec3 const a(positions[indices[3 * t + 0]]);
+        glm::dvec3 const b(positions[indices[3 * t + 1]]);
+        glm::dvec3 const c(positions[indices[3 * t + 2]]);
+        glm::dvec3 const p0(positions[edges[i][0]]);
+        glm::dvec3 const p1(positions[edges[i][1]]);
+        glm::dvec3 const edge = p1 - p0;
+        // Plane through the border edge, perpendicular to its face
+        glm::dvec3 normal = glm::cross(edge, glm::cross(b - a, c - a));
+        double const length = glm::length(normal);
+        if (length == 0.0) {
+            continue;
+        }
+        normal /= length;
+        double const weight = glm::dot(edge, edge) * BORDER_WEIGHT;
+        add_plane(simplifier.quadrics[edges[i][0]], normal, -glm::dot(normal, p0), weight);
+        add_plane(simplifier.quadrics[edges[i][1]], normal, -glm::dot(normal, p0), weight);
+    }
+}
+
+static void simplify_to(Simplifier &simplifier, std::vector<uint32_t> &indices, size_t target_triangles) {
+    while (indices.size() / 3 > target_triangles) {
+        if (collapse_pass(simplifier, indices, target_triangles) == 0) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Applies the cheapest collapses that do not touch each other
+ *
+ * Each accepted collapse locks the ring around the removed vertex, so the
+ * flip checks of later collapses in the same pass stay valid.
+ *
+ * @return Returns the number of collapses done
+ */
+static size_t collapse_pass(Simplifier &simplifier, std::vector<uint32_t> &indices, size_t target_triangles) {
+    std::vector<glm::vec3> const &positions = *simplifier.positions;
+    size_t const vertex_count = positions.size();
+    size_t const triangle_count = indices.size() / 3;
+
+    // Triangles around each vertex, in compressed row form
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (auto index : indices) {
+        offsets[index + 1]++;
+    }
+    for (size_t v = 0; v < vertex_count; v++) {
+        offsets[v + 1] += offsets[v];
+    }
+    std::vector<uint32_t> triangles(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) {
+        triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+        uint32_t const v0 = indices[i];
+        uint32_t const v1 = indices[i - i % 3 + (i + 1) % 3];
+        edges.push_back(std::make_pair(std::min(v0, v1), std::max(v0, v1)));
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    std::vector<Collapse> collapses;
+    collapses.reserve(edges.size());
+    for (auto const &edge : edges) {
+        Quadric merged = simplifier.quadrics[edge.first];
+        add_quadric(merged, simplifier.quadrics[edge.second]);
+        double const to_second = evaluate_quadric(merged, positions[edge.second]);
+        double const to_first = evaluate_quadric(merged, positions[edge.first]);
+        Collapse collapse;
+        if (to_second <= to_first) {
+            collapse.from = edge.first;
+            collapse.to = edge.second;
+            collapse.cost = to_second;
+        } else {
+            collapse.from = edge.second;
+            collapse.to = edge.first;
+            collapse.cost = to_first;
+        }
+        collapses.push_back(collapse);
+    }
+    std::sort(collapses.begin(), collapses.end(),
+              [](Collapse const &a, Collapse const &b) { return a.cost < b.cost; });
+
+    std::vector<uint32_t> remap(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) {
+        remap[v] = static_cast<uint32_t>(v);
+    }
+    std::vector<bool> locked(vertex_count, false);
+    size_t const goal = triangle_count - target_triangles;
+    size_t removed = 0;
+    size_t done = 0;
+    for (auto const &collapse : collapses) {
+        if (removed >= goal) {
+            break;
+        }
+        if (locked[collapse.from] || locked[collapse.to] ||
+            collapse_flips(positions, indices, offsets, triangles, collapse.from, collapse.to)) {
+            continue;
+        }
+
+        for (uint32_t i = offsets[collapse.from]; i < offsets[collapse.from + 1]; i++) {
+            uint32_t const *triangle = &indices[3 * triangles[i]];
+            bool degenerate = false;
+            for (int corner = 0; corner < 3; corner++) {
+                locked[triangle[corner]] = true;
+                degenerate = degenerate || triangle[corner] == collapse.to;
+            }
+            removed += degenerate ? 1 : 0;
+        }
+        remap[collapse.from] = collapse.to;
+        Quadric &target = simplifier.quadrics[collapse.to];
+        add_quadric(target, simplifier.quadrics[collapse.from]);
+        if (target.weight > 0.0) {
+            float const error = static_cast<float>(std::sqrt(std::max(collapse.cost, 0.0) / target.weight));
+            simplifier.error = std::max(simplifier.error, error);
+        }
+        done++;
+    }
+
+    size_t kept = 0;
+    for (size_t t = 0; t < triangle_count; t++) {
+        uint32_t const a = remap[indices[3 * t + 0]];
+        uint32_t const b = remap[indices[3 * t + 1]];
+        uint32_t const c = remap[indices[3 * t + 2]];
+        if (a == b || b == c || c == a) {
+            continue;
+        }
+        indices[3 * kept + 0] = a;
+        indices[3 * kept + 1] = b;
+        indices[3 * kept + 2] = c;
+        kept++;
+    }
+    indices.resize(3 * kept);
+    return done;
+}
+
+static bool collapse_flips(std::vector<glm::vec3> const &positions, std::vector<uint32_t> const &indices,
+                           std::vector<uint32_t> const &offsets, std::vector<uint32_t> const &triangles,
+                           uint32_t from, uint32_t to) {
+    for (uint32_t i = offsets[from]; i < offsets[from + 1]; i++) {
+        uint32_t const *triangle = &indices[3 * triangles[i]];
+        if (triangle[0] == to || triangle[1] == to || triangle[2] == to) {
+            // Removed by the collapse
+            continue;
+        }
+        glm::vec3 corners[3];
+        glm::vec3 moved[3];
+        for (int corner = 0; corner < 3; corner++) {
+            corners[corner] = positions[triangle[corner]];
+            moved[corner] = triangle[corner] == from ? positions[to] : corners[corner];
+        }
+        glm::vec3 const before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+        glm::vec3 const after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+        if (glm::dot(before, after) <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void add_plane(Quadric &quadric, glm::dvec3 const &normal, double distance, double weight) {
+    double const plane[4] = {normal.x, normal.y, normal.z, distance};
+    int k = 0;
+    for (int row = 0; row < 4; row++) {
+        for (int column = row; column < 4; column++) {
+            quadric.a[k++] += weight * plane[row] * plane[column];
+        }
+    }
+    quadric.weight += weight;
+}
+
+static void add_quadric(Quadric &quadric, Quadric const &other) {
+    for (int i = 0; i < 10; i++) {
+        quadric.a[i] += other.a[i];
+    }
+    quadric.weight += other.weight;
+}
+
+static double evaluate_quadric(Quadric const &quadric, glm::vec3 const &point) {
+    double const v[4] = {point.x, point.y, point.z, 1.0};
+    double error = 0.0;
+    int k = 0;
+    for (int row = 0; row < 4; row++) {
+        for (int column = row; column < 4; column++) {
+            // Off-diagonal terms appear twice in the full matrix
+            error += (row == column ? 1.0 : 2.0) * quadric.a[k++] * v[row] * v[column];
+        }
+    }
+    return error;
+}
@@ -0,0 +1,69 @@
+#ifndef MESH_SIMPLIFY_H_
+#define MESH_SIMPLIFY_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// Each level aims for this fraction of the triangles of the previous one
+constexpr float LOD_REDUCTION = 0.5f;
+// Levels are not built below this many triangles
+constexpr size_t LOD_MIN_TRIANGLES = 256;
+constexpr size_t MAX_MESH_LODS = 8;
+// Default screen space error allowed when picking a level, in pixels
+constexpr float LOD_PIXEL_ERROR = 1.0f;
+
+/**
+ * @brief Collapses edges by quadric error until few enough triangles remain
+ *
+ * Vertices are only ever merged onto a neighbour, so the result indexes the
+ * same positions. Collapses that would flip a face are skipped and mesh
+ * borders are weighted to stay in place.
+ *
+ * @param positions Vertex positions
+ * @param indices Triangle list, simplified in place
+ * @param target_triangles Triangle count to stop at
+ * @return Returns the largest distance the surface moved, in model units
+ */
+float simplify_indices(std::vector<glm::vec3> const &positions, std::vector<uint32_t> &indices,
+                       size_t target_triangles);
+
+/**
+ * @brief Fills mesh.lods with a chain of simplified levels
+ *
+ * Every level has about LOD_REDUCTION times the triangles of the one before,
+ * stopping at LOD_MIN_TRIANGLES or once simplification stalls.
+ *
+ * @param mesh Mesh to simplify, its own indices are left untouched
+ */
+void build_mesh_lods(Mesh &mesh);
+
+/**
+ * @brief Picks the coarsest level whose error stays under a pixel budget
+ *
+ * The error is projected at the nearest point of the model, taken as
+ * view_distance minus half of model_size.
+ *
+ * @param mesh Mesh with lods
+ * @param view_distance Distance from the camera to the model center
+ * @param fov Vertical field of view in degrees
+ * @param viewport_height Height of the viewport in pixels
+ * @param pixel_error Largest allowed error in pixels
+ * @return Returns 0 for the full mesh, otherwise 1 + index into mesh.lods
+ */
+size_t select_mesh_lod(Mesh const &mesh, float view_distance, float fov, float viewport_height,
+                       float pixel_error = LOD_PIXEL_ERROR);
+
+/**
+ * @brief Face id of the first triangle of a level
+ *
+ * Levels are numbered back to back, full mesh first, so every triangle of
+ * every level has its own id whichever part of it is drawn. Coloring by face
+ * adds the triangle's index within its level to this.
+ *
+ * @param mesh Mesh with lods
+ * @param lod 0 for the full mesh, otherwise 1 + index into mesh.lods
+ * @return Returns the number of triangles in the levels before lod
+ */
+uint32_t mesh_lod_first_face(Mesh const &mesh, size_t lod);
+
+#endif  // MESH_SIMPLIFY_H_
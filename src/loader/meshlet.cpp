@@ -0,0 +1,180 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include "half_float.hpp"
+#include "mesh_optimize.hpp"
+
+static uint32_t morton_code(glm::vec3 const &point, glm::vec3 const &bounds_min, glm::vec3 const &scale);
+static uint32_t spread_bits(uint32_t value);
+static void compute_meshlet_bounds(std::vector<glm::vec3> const &positions, std::vector<uint32_t> const &indices,
+                                   Meshlet &meshlet);
+
+void build_meshlets(Mesh &mesh) {
+    mesh.meshlets.clear();
+    size_t const triangle_count = mesh.indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    std::vector<glm::vec3> decoded;
+    if (mesh.positions.empty()) {
+        decoded.resize(mesh.half_positions.size());
+        convert_float16_to_float32(&mesh.half_positions[0].x, &decoded[0].x, decoded.size() * 3);
+    }
+    std::vector<glm::vec3> const &positions = mesh.positions.empty() ? decoded : mesh.positions;
+
+    glm::vec3 bounds_min = positions[mesh.indices[0]];
+    glm::vec3 bounds_max = bounds_min;
+    for (auto index : mesh.indices) {
+        bounds_min = glm::min(bounds_min, positions[index]);
+        bounds_max = glm::max(bounds_max, positions[index]);
+    }
+    glm::vec3 const extent = bounds_max - bounds_min;
+    glm::vec3 scale(0.0f);
+    for (int i = 0; i < 3; i++) {
+        scale[i] = extent[i] > 0.0f ? 1023.0f / extent[i] : 0.0f;
+    }
+
+    // Sorting by the Morton code of the face centers keeps neighbours together
+    std::vector<std::pair<uint32_t, uint32_t>> order(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++) {
+        glm::vec3 const center = (positions[mesh.indices[3 * t + 0]] + positions[mesh.indices[3 * t + 1]] +
+                                  positions[mesh.indices[3 * t + 2]]) / 3.0f;
+        order[t] = std::make_pair(morton_code(center, bounds_min, scale), static_cast<uint32_t>(t));
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<uint32_t> sorted(mesh.indices.size());
+    for (size_t t = 0; t < triangle_count; t++) {
+        std::copy(mesh.indices.begin() + 3 * order[t].second, mesh.indices.begin() + 3 * order[t].second + 3,
+                  sorted.begin() + 3 * t);
+    }
+
+    size_t const vertex_count = positions.size();
+    std::vector<uint32_t> meshlet_indices;
+    for (size_t first = 0; first < triangle_count; first += MESHLET_MAX_TRIANGLES) {
+        size_t const count = std::min(MESHLET_MAX_TRIANGLES, triangle_count - first);
+        meshlet_indices.assign(sorted.begin() + 3 * first, sorted.begin() + 3 * (first + count));
+        optimize_vertex_cache(meshlet_indices, vertex_count);
+        std::copy(meshlet_indices.begin(), meshlet_indices.end(), sorted.begin() + 3 * first);
+
+        Meshlet meshlet;
+        meshlet.first_index = static_cast<uint32_t>(3 * first);
+        meshlet.index_count = static_cast<uint32_t>(3 * count);
+        compute_meshlet_bounds(positions, meshlet_indices, meshlet);
+        mesh.meshlets.push_back(meshlet);
+    }
+    mesh.indices.swap(sorted);
+}
+
+void extract_frustum(glm::mat4 const &mvp, Frustum &frustum) {
+    // Gribb-Hartmann: each plane is the last row plus or minus another row
+    for (int i = 0; i < 3; i++) {
+        for (int side = 0; side < 2; side++) {
+            glm::vec4 plane;
+            for (int column = 0; column < 4; column++) {
+                float const sign = side == 0 ? 1.0f : -1.0f;
+                plane[column] = mvp[column][3] + sign * mvp[column][i];
+            }
+            float const length = glm::length(glm::vec3(plane));
+            frustum.planes[2 * i + side] = length > 0.0f ? plane / length : plane;
+        }
+    }
+}
+
+bool meshlet_visible(Meshlet const &meshlet, Frustum const &frustum, glm::vec3 const &camera_position,
+                     bool cull_backfaces) {
+    for (auto const &plane : frustum.planes) {
+        if (glm::dot(glm::vec3(plane), meshlet.center) + plane.w < -meshlet.radius) {
+            return false;
+        }
+    }
+    if (cull_backfaces) {
+        // Every face points away when the view direction is outside the cone
+        glm::vec3 const view = meshlet.center - camera_position;
+        if (glm::dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(view) + meshlet.radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t cull_meshlets(std::vector<Meshlet> const &meshlets, Frustum const &frustum, glm::vec3 const &camera_position,
+                     bool cull_backfaces, std::vector<MeshletRange> &ranges) {
+    ranges.clear();
+    size_t visible = 0;
+    for (auto const &meshlet : meshlets) {
+        if (!meshlet_visible(meshlet, frustum, camera_position, cull_backfaces)) {
+            continue;
+        }
+        visible++;
+        if (!ranges.empty() && ranges.back().first_index + ranges.back().index_count == meshlet.first_index) {
+            ranges.back().index_count += meshlet.index_count;
+        } else {
+            MeshletRange range;
+            range.first_index = meshlet.first_index;
+            range.index_count = meshlet.index_count;
+            ranges.push_back(range);
+        }
+    }
+    return visible;
+}
+
+static uint32_t morton_code(glm::vec3 const &point, glm::vec3 const &bounds_min, glm::vec3 const &scale) {
+    uint32_t code = 0;
+    for (int i = 0; i < 3; i++) {
+        uint32_t const cell = static_cast<uint32_t>(std::min(std::max((point[i] - bounds_min[i]) * scale[i], 0.0f), 1023.0f));
+        code |= spread_bits(cell) << i;
+    }
+    return code;
+}
+
+// Puts two zero bits between each of the 10 low bits
+static uint32_t spread_bits(uint32_t value) {
+    value &= 0x3FF;
+    value = (value | (value << 16)) & 0x030000FF;
+    value = (value | (value << 8)) & 0x0300F00F;
+    value = (value | (value << 4)) & 0x030C30C3;
+    value = (value | (value << 2)) & 0x09249249;
+    return value;
+}
+
+static void compute_meshlet_bounds(std::vector<glm::vec3> const &positions, std::vector<uint32_t> const &indices,
+                                   Meshlet &meshlet) {
+    glm::vec3 low = positions[indices[0]];
+    glm::vec3 high = low;
+    glm::vec3 normal_sum(0.0f);
+    std::vector<glm::vec3> normals;
+    normals.reserve(indices.size() / 3);
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        glm::vec3 const &a = positions[indices[i + 0]];
+        glm::vec3 const &b = positions[indices[i + 1]];
+        glm::vec3 const &c = positions[indices[i + 2]];
+        low = glm::min(low, glm::min(a, glm::min(b, c)));
+        high = glm::max(high, glm::max(a, glm::max(b, c)));
+        glm::vec3 const normal = glm::cross(b - a, c - a);
+        float const length = glm::length(normal);
+        if (length > 0.0f) {
+            normals.push_back(normal / length);
+            normal_sum += normal / length;
+        }
+    }
+
+    meshlet.center = (low + high) * 0.5f;
+    float radius_squared = 0.0f;
+    for (auto index : indices) {
+        glm::vec3 const offset = positions[index] - meshlet.center;
+        radius_squared = std::max(radius_squared, glm::dot(offset, offset));
+    }
+    meshlet.radius = std::sqrt(radius_squared);
+
+    float const axis_length = glm::length(normal_sum);
+    meshlet.cone_axis = axis_length > 0.0f ? normal_sum / axis_length : glm::vec3(0.0f, 0.0f, 1.0f);
+    float min_dot = axis_length > 0.0f ? 1.0f : -1.0f;
+    for (auto const &normal : normals) {
+        min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+    }
+    // Past 90 degrees of spread some face always looks back at the camera
+    meshlet.cone_cutoff = min_dot <= 0.0f ? 1.0f : std::sqrt(1.0f - min_dot * min_dot);
+}
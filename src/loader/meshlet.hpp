@@ -0,0 +1,71 @@
+#ifndef MESHLET_H_
+#define MESHLET_H_
+
+#include "../includes/common.h"
+#include "mesh.hpp"
+
+// Triangles per cluster, small enough to cull finely, big enough to draw cheaply
+constexpr size_t MESHLET_MAX_TRIANGLES = 256;
+
+/**
+ * @brief Clip space planes as (normal, distance), normals point inwards
+ */
+struct Frustum {
+    glm::vec4 planes[6];
+};
+
+/**
+ * @brief Range of mesh.indices to draw
+ */
+struct MeshletRange {
+    uint32_t first_index;
+    uint32_t index_count;
+};
+
+/**
+ * @brief Splits the mesh into clusters of nearby triangles
+ *
+ * Faces are sorted along a Morton curve of their centers and cut into runs
+ * of MESHLET_MAX_TRIANGLES, then each run is reordered for the vertex cache.
+ * mesh.indices is rewritten so every meshlet is contiguous.
+ *
+ * @param mesh Mesh to split, fills mesh.meshlets
+ */
+void build_meshlets(Mesh &mesh);
+
+/**
+ * @brief Extracts the view frustum planes from a model view projection
+ *
+ * @param mvp Matrix from compute_mvp
+ * @param frustum Output normalized planes
+ */
+void extract_frustum(glm::mat4 const &mvp, Frustum &frustum);
+
+/**
+ * @brief Tells if any part of a meshlet may be seen
+ *
+ * @param meshlet Meshlet to test
+ * @param frustum Planes from extract_frustum
+ * @param camera_position Camera position in model space
+ * @param cull_backfaces Also reject meshlets whose normal cone faces away
+ */
+bool meshlet_visible(Meshlet const &meshlet, Frustum const &frustum, glm::vec3 const &camera_position,
+                     bool cull_backfaces);
+
+/**
+ * @brief Collects the visible meshlets as index ranges
+ *
+ * Neighbouring visible meshlets are merged into one range so they cost a
+ * single draw call.
+ *
+ * @param meshlets Meshlets of the mesh
+ * @param frustum Planes from extract_frustum
+ * @param camera_position Camera position in model space
+ * @param cull_backfaces Also reject meshlets whose normal cone faces away
+ * @param ranges Output ranges of mesh.indices
+ * @return Returns the number of visible meshlets
+ */
+size_t cull_meshlets(std::vector<Meshlet> const &meshlets, Frustum const &frustum, glm::vec3 const &camera_position,
+                     bool cull_backfaces, std::vector<MeshletRange> &ranges);
+
+#endif  // MESHLET_H_
@@ -0,0 +1,337 @@
+#include "pure_model.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include "mapped_file.hpp"
+#include "half_float.hpp"
+
+/**
+ * @brief How the index block of a LOD variant is delimited
+ *
+ * The block starts at the first FIRST_FACE marker on an 8 byte boundary and
+ * ends at the first end marker found, at any byte, past skip bytes.
+ */
+struct PureIndexBlock {
+    uint64_t skip;
+    uint64_t end_marker;
+    uint64_t other_end_marker;
+};
+
+/**
+ * @brief A LOD variant: tag found in the file name and how to load it
+ */
+struct PureModelVariant {
+    char const *lod_tag;
+    PureIndexBlock index_block;
+    void (*load)(char const *filename, MappedFile const &file, PureIndexBlock const &index_block,
+                 bool keep_half_positions, Mesh &mesh, LoadStats *stats);
+    // Bitmask of PureVertexAttribute, for writing
+    uint32_t attributes;
+};
+
+template <typename Layout>
+static void load_pure_model_layout(char const *filename, MappedFile const &file, PureIndexBlock const &index_block,
+                                   bool keep_half_positions, Mesh &mesh, LoadStats *stats);
+static bool check_pure_model_header(MappedFile const &file);
+static uint64_t find_face_marker(MappedFile const &file, uint64_t from, uint64_t stride,
+                                 uint64_t marker, uint64_t other_marker);
+static PureModelVariant const *find_pure_model_variant(std::string const &path);
+static bool pick_marker_faces(std::vector<uint32_t> const &indices, uint32_t corners[3], size_t &second_face);
+static void write_pure_vertex(uint32_t attributes, glm::u16vec3 const &position, char *vertex);
+
+static PureModelVariant const PURE_MODEL_VARIANTS[] = {
+    {"LOD1", {sizeof(uint64_t) * 5, FIRST_FACE, LOD3_END_FACE}, load_pure_model_layout<PureLayoutLod1>,
+     PureLayoutLod1::attributes},
+    {"LOD3", {sizeof(uint64_t), LOD3_END_FACE, LOD3_END_FACE}, load_pure_model_layout<PureLayoutLod3>,
+     PureLayoutLod3::attributes},
+};
+
+void load_pure_model(std::string const &path, Mesh &mesh, bool keep_half_positions, LoadStats *stats)
+{
+    PureModelVariant const *variant = find_pure_model_variant(path);
+    if (variant == nullptr) {
+        printf("Unrecognized LOD level for file: %s\n", path.c_str());
+        return;
+    }
+
+    MappedFile file;
+    bool valid = false;
+    {
+        LoadStageTimer timer(stats, LOAD_STAGE_READ);
+        if (!open_mapped_file(path.c_str(), file)) {
+            return;
+        }
+        add_load_bytes(stats, LOAD_STAGE_READ, file.size);
+        valid = check_pure_model_header(file);
+    }
+    if (valid) {
+        variant->load(path.c_str(), file, variant->index_block, keep_half_positions, mesh, stats);
+    }
+    close_mapped_file(file);
+    fflush(stdin);
+}
+
+template <typename Layout>
+static void load_pure_model_layout(char const *filename, MappedFile const &file, PureIndexBlock const &index_block,
+                                   bool keep_half_positions, Mesh &mesh, LoadStats *stats)
+{
+    // Find indices, the block starts on an 8 byte boundary
+    LoadStageTimer timer(stats, LOAD_STAGE_MARKER_SEARCH);
+    uint64_t const INDICES_OFFSET = find_face_marker(file, VERTICES_OFFSET, sizeof(uint64_t), FIRST_FACE, FIRST_FACE);
+    uint64_t const INDICES_END = find_face_marker(file, INDICES_OFFSET + index_block.skip, 1,
+                                                  index_block.end_marker, index_block.other_end_marker);
+    if (INDICES_END >= file.size) {
+        printf("Could not find the indices block in file: '%s'\n", filename);
+        return;
+    }
+    add_load_bytes(stats, LOAD_STAGE_MARKER_SEARCH, INDICES_END - VERTICES_OFFSET);
+    uint64_t const INDICES_COUNT = (INDICES_END - INDICES_OFFSET) / sizeof(uint16_t);
+
+    timer.next(LOAD_STAGE_PARSE);
+    add_load_bytes(stats, LOAD_STAGE_PARSE, INDICES_COUNT * sizeof(uint16_t));
+
+    std::vector<uint16_t> indices(INDICES_COUNT);
+    printf("Indices start at address: 0x%08lx\n", INDICES_OFFSET);
+    memcpy(indices.data(), file.data + INDICES_OFFSET, INDICES_COUNT * sizeof(uint16_t));
+    printf("Indices end at address: 0x%08lx\n", INDICES_OFFSET + INDICES_COUNT * sizeof(uint16_t));
+
+    // The vertex block runs from VERTICES_OFFSET up to the highest index used
+    uint64_t const VERTEX_COUNT = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end()) + 1;
+    uint64_t const VERTICES_END = VERTICES_OFFSET + VERTEX_COUNT * Layout::stride;
+    if (VERTICES_END > INDICES_OFFSET) {
+        printf("Vertices overlap the indices block in file: '%s'\n", filename);
+        return;
+    }
+    printf("Vertices start at address: 0x%08lx\n", VERTICES_OFFSET);
+    printf("Vertices end at address: 0x%08lx\n", VERTICES_END);
+    add_load_bytes(stats, LOAD_STAGE_PARSE, VERTICES_END - VERTICES_OFFSET);
+
+    // Pull the positions out of the block with a compile-time stride and
+    // decode them all at once
+    std::vector<hvec3> half_positions(VERTEX_COUNT);
+    char const *vertex = file.data + VERTICES_OFFSET + Layout::position_offset;
+    for (uint64_t i = 0; i < VERTEX_COUNT; i++, vertex += Layout::stride)
+    {
+        memcpy(&half_positions[i], vertex, sizeof(hvec3));
+    }
+    static_assert(sizeof(hvec3) == 3 * sizeof(uint16_t), "hvec3 must be tightly packed");
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "vec3 must be tightly packed");
+    if (keep_half_positions) {
+        mesh.half_positions.swap(half_positions);
+    } else if (VERTEX_COUNT > 0) {
+        timer.next(LOAD_STAGE_HALF_DECODE);
+        add_load_bytes(stats, LOAD_STAGE_HALF_DECODE, VERTEX_COUNT * sizeof(hvec3));
+        mesh.positions.resize(VERTEX_COUNT);
+        convert_float16_to_float32(&half_positions[0].x, &mesh.positions[0].x, VERTEX_COUNT * 3);
+    }
+
+    // Faces are stored with the opposite winding
+    timer.next(LOAD_STAGE_INDEX_BUILD);
+    add_load_bytes(stats, LOAD_STAGE_INDEX_BUILD, INDICES_COUNT / 3 * 3 * sizeof(uint32_t));
+    mesh.indices.resize(INDICES_COUNT / 3 * 3);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        mesh.indices[i] = indices[i + 2];
+        mesh.indices[i + 1] = indices[i + 1];
+        mesh.indices[i + 2] = indices[i];
+    }
+}
+
+bool save_pure_model(std::string const &path, Mesh const &mesh)
+{
+    PureModelVariant const *variant = find_pure_model_variant(path);
+    if (variant == nullptr) {
+        printf("Unrecognized LOD level for file: %s\n", path.c_str());
+        return false;
+    }
+    size_t const vertex_count = mesh_vertex_count(mesh);
+    if (vertex_count > PURE_MAX_VERTICES) {
+        printf("%zu vertices do not fit the 16 bit indices of file: '%s'\n", vertex_count, path.c_str());
+        return false;
+    }
+    uint32_t corners[3];
+    size_t second_face = 0;
+    if (!pick_marker_faces(mesh.indices, corners, second_face)) {
+        printf("Needs two faces sharing a vertex to write file: '%s'\n", path.c_str());
+        return false;
+    }
+
+    // The corners of the first face become vertices 0, 1 and 2, the rest keep their order
+    std::vector<uint32_t> remap(vertex_count, 0);
+    std::vector<uint32_t> order(corners, corners + 3);
+    for (uint32_t i = 0; i < 3; i++) {
+        remap[corners[i]] = i + 1;
+    }
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        if (remap[i] == 0) {
+            order.push_back(i);
+        }
+        remap[i] = 0;
+    }
+    for (uint32_t i = 0; i < vertex_count; i++) {
+        remap[order[i]] = i;
+    }
+
+    // Faces are stored with the opposite winding, the second face moves up
+    // and is rotated so the block starts 0, 1, 2, 1 like FIRST_FACE
+    size_t const face_count = mesh.indices.size() / 3;
+    std::vector<uint16_t> indices(face_count * 3);
+    for (size_t face = 0; face < face_count; face++) {
+        size_t const source = face == 1 ? second_face : face == second_face ? 1 : face;
+        for (size_t k = 0; k < 3; k++) {
+            indices[face * 3 + k] = static_cast<uint16_t>(remap[mesh.indices[source * 3 + 2 - k]]);
+        }
+    }
+    std::rotate(indices.begin(), std::find(indices.begin(), indices.begin() + 3, 0), indices.begin() + 3);
+    std::rotate(indices.begin() + 3, std::find(indices.begin() + 3, indices.begin() + 6, 1), indices.begin() + 6);
+
+    size_t const stride = pure_attributes_size(variant->attributes);
+    uint64_t const indices_offset = (VERTICES_OFFSET + vertex_count * stride + 7) / 8 * 8;
+    uint64_t const indices_end = indices_offset + indices.size() * sizeof(uint16_t);
+    std::vector<char> bytes(indices_end + sizeof(uint64_t), static_cast<char>(0xFF));
+    uint32_t const header[2] = {5, 0};
+    memcpy(bytes.data(), header, sizeof(header));
+    std::vector<glm::u16vec3> half_positions(vertex_count);
+    for (size_t i = 0; i < vertex_count; i++) {
+        if (mesh.positions.empty()) {
+            half_positions[i] = mesh.half_positions[order[i]];
+            continue;
+        }
+        for (int axis = 0; axis < 3; axis++) {
+            half_positions[i][axis] = convert_float32_to_float16(mesh.positions[order[i]][axis]);
+        }
+    }
+    for (size_t i = 0; i < vertex_count; i++) {
+        write_pure_vertex(variant->attributes, half_positions[i], &bytes[VERTICES_OFFSET + i * stride]);
+    }
+    memcpy(&bytes[indices_offset], indices.data(), indices.size() * sizeof(uint16_t));
+    uint64_t const end_marker = LOD3_END_FACE;
+    memcpy(&bytes[indices_end], &end_marker, sizeof(end_marker));
+
+    // Run the same marker search as the loader, tiny positions or unlucky
+    // index runs could spell out a marker early
+    MappedFile view;
+    view.data = bytes.data();
+    view.size = bytes.size();
+    PureIndexBlock const &block = variant->index_block;
+    if (find_face_marker(view, VERTICES_OFFSET, sizeof(uint64_t), FIRST_FACE, FIRST_FACE) != indices_offset ||
+        find_face_marker(view, indices_offset + block.skip, 1, block.end_marker, block.other_end_marker) !=
+            indices_end) {
+        printf("The data contains a block marker, can't write file: '%s'\n", path.c_str());
+        return false;
+    }
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) {
+        printf("There was an error opening file: '%s'\n", path.c_str());
+        return false;
+    }
+    bool const ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    return fclose(file) == 0 && ok;
+}
+
+static PureModelVariant const *find_pure_model_variant(std::string const &path)
+{
+    for (auto const &candidate : PURE_MODEL_VARIANTS) {
+        if (path.find(candidate.lod_tag) != path.npos) {
+            return &candidate;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finds the first face's corners in stored order, rotated so the
+ * middle one is shared with another face
+ */
+static bool pick_marker_faces(std::vector<uint32_t> const &indices, uint32_t corners[3], size_t &second_face)
+{
+    if (indices.size() < 6 || indices[0] == indices[1] || indices[1] == indices[2] || indices[0] == indices[2]) {
+        return false;
+    }
+    uint32_t const stored[3] = {indices[2], indices[1], indices[0]};
+    for (size_t face = 1; face < indices.size() / 3; face++) {
+        for (int rotation = 0; rotation < 3; rotation++) {
+            uint32_t const shared = stored[(rotation + 1) % 3];
+            if (indices[face * 3] == shared || indices[face * 3 + 1] == shared || indices[face * 3 + 2] == shared) {
+                for (int k = 0; k < 3; k++) {
+                    corners[k] = stored[(rotation + k) % 3];
+                }
+                second_face = face;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief One vertex with the given position and constant other attributes
+ */
+static void write_pure_vertex(uint32_t attributes, glm::u16vec3 const &position, char *vertex)
+{
+    // Halves of 0 and 1: normal +y, binormals +x and +z, UV 0
+    uint16_t const normal[3] = {0x0000, 0x3C00, 0x0000};
+    uint16_t const binormals[6] = {0x3C00, 0x0000, 0x0000, 0x0000, 0x0000, 0x3C00};
+    uint16_t const uv[2] = {0x0000, 0x0000};
+    memcpy(vertex + pure_attribute_offset(attributes, PURE_POSITION), &position, sizeof(hvec3));
+    if (attributes & PURE_NORMAL) {
+        memcpy(vertex + pure_attribute_offset(attributes, PURE_NORMAL), normal, sizeof(normal));
+    }
+    if (attributes & PURE_UV) {
+        memcpy(vertex + pure_attribute_offset(attributes, PURE_UV), uv, sizeof(uv));
+    }
+    if (attributes & PURE_BINORMALS) {
+        memcpy(vertex + pure_attribute_offset(attributes, PURE_BINORMALS), binormals, sizeof(binormals));
+    }
+}
+
+static bool check_pure_model_header(MappedFile const &file)
+{
+    // The files start with a magic number 5, then are followed by a weird
+    // number that changes per model
+    uint32_t magic_number = 0;
+    if (file.size >= VERTICES_OFFSET) {
+        memcpy(&magic_number, file.data, sizeof(uint32_t));
+    }
+    if (magic_number != 5) {
+        printf("Not a model file. Needs the magic number 5 at the beginning\n");
+        return false;
+    }
+    return true;
+}
+
+static uint64_t find_face_marker(MappedFile const &file, uint64_t from, uint64_t stride,
+                                 uint64_t marker, uint64_t other_marker)
+{
+    // Every marker is stored as 00 00 01 00 02 00 xx 00, so let memchr find
+    // the 0x02 byte and only compare the full 8 bytes at those candidates
+    constexpr unsigned KEY_BYTE = 4;
+    char const key = static_cast<char>((marker >> (KEY_BYTE * 8)) & 0xFF);
+    assert(key == static_cast<char>((other_marker >> (KEY_BYTE * 8)) & 0xFF));
+
+    if (file.size < sizeof(uint64_t)) {
+        return file.size;
+    }
+    uint64_t const last = file.size - sizeof(uint64_t);
+    uint64_t offset = from;
+    while (offset <= last) {
+        auto hit = static_cast<char const *>(memchr(file.data + offset + KEY_BYTE, key, last - offset + 1));
+        if (hit == nullptr) {
+            break;
+        }
+        uint64_t const candidate = static_cast<uint64_t>(hit - file.data) - KEY_BYTE;
+        uint64_t const misalignment = (candidate - from) % stride;
+        if (misalignment != 0) {
+            offset = candidate + stride - misalignment;
+            continue;
+        }
+        uint64_t value;
+        memcpy(&value, file.data + candidate, sizeof(uint64_t));
+        if (value == marker || value == other_marker) {
+            return candidate;
+        }
+        offset = candidate + stride;
+    }
+    return file.size;
+}
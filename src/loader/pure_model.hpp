@@ -0,0 +1,98 @@
+#ifndef PURE_MODEL_H_
+#define PURE_MODEL_H_
+
+#include "../includes/common.h"
+#include "load_stats.hpp"
+#include "mesh.hpp"
+
+typedef glm::u16vec3 hvec3;
+typedef glm::u16vec2 hvec2;
+
+// Vertices always start at address 8
+constexpr uint64_t VERTICES_OFFSET = 0x08;
+constexpr uint64_t FIRST_FACE = 0x1000200010000;
+constexpr uint64_t LOD3_END_FACE = 0x3000200010000;
+// Indices are 16 bit
+constexpr size_t PURE_MAX_VERTICES = 1 << 16;
+
+/**
+ * @brief Attributes a PureParts vertex can hold, stored in this order
+ */
+enum PureVertexAttribute : uint32_t {
+    PURE_POSITION = 1u << 0,   // hvec3
+    PURE_NORMAL = 1u << 1,     // hvec3
+    PURE_UV = 1u << 2,         // hvec2
+    PURE_BINORMALS = 1u << 3,  // hvec3[2]
+};
+
+/**
+ * @brief Bytes taken by a set of attributes
+ *
+ * @param attributes Bitmask of PureVertexAttribute
+ */
+constexpr size_t pure_attributes_size(uint32_t attributes) {
+    return ((attributes & PURE_POSITION) ? sizeof(hvec3) : 0) +
+           ((attributes & PURE_NORMAL) ? sizeof(hvec3) : 0) +
+           ((attributes & PURE_UV) ? sizeof(hvec2) : 0) +
+           ((attributes & PURE_BINORMALS) ? 2 * sizeof(hvec3) : 0);
+}
+
+/**
+ * @brief Offset of one attribute inside a vertex, after all lower attributes
+ *
+ * @param attributes Bitmask of PureVertexAttribute stored in the vertex
+ * @param attribute Attribute to locate
+ */
+constexpr size_t pure_attribute_offset(uint32_t attributes, PureVertexAttribute attribute) {
+    return pure_attributes_size(attributes & (attribute - 1));
+}
+
+/**
+ * @brief Compile-time description of a PureParts vertex layout
+ *
+ * @tparam Attributes Bitmask of PureVertexAttribute stored per vertex
+ */
+template <uint32_t Attributes>
+struct PureVertexLayout {
+    static_assert((Attributes & PURE_POSITION) != 0, "PureParts vertices always store a position");
+
+    static constexpr uint32_t attributes = Attributes;
+    static constexpr size_t stride = pure_attributes_size(Attributes);
+    static constexpr size_t position_offset = pure_attribute_offset(Attributes, PURE_POSITION);
+};
+
+// Size = 28 Bytes
+typedef PureVertexLayout<PURE_POSITION | PURE_NORMAL | PURE_UV | PURE_BINORMALS> PureLayoutLod1;
+// Size = 24 Bytes
+typedef PureVertexLayout<PURE_POSITION | PURE_NORMAL | PURE_BINORMALS> PureLayoutLod3;
+
+static_assert(PureLayoutLod1::stride == 28, "LOD1 vertices are 28 bytes");
+static_assert(PureLayoutLod3::stride == 24, "LOD3 vertices are 24 bytes");
+
+/**
+ * @brief Loads a PureParts .model file, picking the LOD variant from the path
+ *
+ * @param path Path to the file, must contain the LOD tag (e.g. "LOD1")
+ * @param mesh Mesh the positions and faces are written to
+ * @param keep_half_positions Store the raw halves in mesh.half_positions
+ * instead of decoding them into mesh.positions
+ * @param stats Optional per-stage durations and byte counts, added to
+ */
+void load_pure_model(std::string const &path, Mesh &mesh, bool keep_half_positions = false,
+                     LoadStats *stats = nullptr);
+
+/**
+ * @brief Writes a mesh as a PureParts .model file that load_pure_model reads back
+ *
+ * The layout comes from the LOD tag in the path like when loading. Only
+ * positions are meaningful, normals, UVs and binormals are constants. The
+ * vertices are renumbered and the first faces reordered so the index block
+ * opens with the FIRST_FACE marker; the faces keep their winding.
+ *
+ * @param path Output path, must contain the LOD tag (e.g. "LOD3")
+ * @param mesh Mesh with float or half positions, at most 65536 vertices
+ * @return Returns false and prints the problem if the mesh can't be stored
+ */
+bool save_pure_model(std::string const &path, Mesh const &mesh);
+
+#endif  // PURE_MODEL_H_
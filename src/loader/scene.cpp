@@ -0,0 +1,199 @@
+#include "scene.hpp"
+
+#include <algorithm>
+#include <map>
+
+static bool parse_scene_line(std::string const &line, std::string &model_path, glm::mat4 &transform);
+static std::string resolve_scene_path(std::string const &scene_path, std::string const &model_path);
+
+bool load_scene(std::string const &path, Scene &scene, unsigned flags, LoadControl *control, LoadStats *stats) {
+    scene = Scene();
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        printf("There was an error opening file: '%s'\n", path.c_str());
+        return false;
+    }
+
+    // Identical paths share one mesh
+    std::map<std::string, uint32_t> mesh_ids;
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        size_t const start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        std::string model_path;
+        SceneInstance instance;
+        if (!parse_scene_line(line, model_path, instance.transform)) {
+            printf("Invalid instance on line %zu of '%s'\n", line_number, path.c_str());
+            scene = Scene();
+            return false;
+        }
+        model_path = resolve_scene_path(path, model_path);
+        auto const found = mesh_ids.find(model_path);
+        if (found == mesh_ids.end()) {
+            instance.mesh = static_cast<uint32_t>(scene.mesh_paths.size());
+            mesh_ids[model_path] = instance.mesh;
+            scene.mesh_paths.push_back(model_path);
+        } else {
+            instance.mesh = found->second;
+        }
+        scene.instances.push_back(instance);
+    }
+
+    scene.meshes.resize(scene.mesh_paths.size());
+    for (size_t i = 0; i < scene.mesh_paths.size(); i++) {
+        if (control != nullptr) {
+            if (control->cancelled) {
+                break;
+            }
+            // Each mesh reports its own progress within its share of the scene
+            float const count = static_cast<float>(scene.mesh_paths.size());
+            control->progress_offset = static_cast<float>(i) / count;
+            control->progress_scale = 1.0f / count;
+        }
+        load_model(scene.mesh_paths[i], scene.meshes[i], flags, control, stats);
+    }
+    if (control != nullptr) {
+        control->progress_offset = 0.0f;
+        control->progress_scale = 1.0f;
+        // Cancelled between meshes or part way through one
+        if (control->cancelled) {
+            scene = Scene();
+            return false;
+        }
+        control->progress = 1.0f;
+    }
+
+    calculate_scene_bounds(scene);
+    return true;
+}
+
+void make_mesh_scene(std::string const &path, Mesh &mesh, Scene &scene) {
+    scene = Scene();
+    scene.mesh_paths.push_back(path);
+    scene.meshes.push_back(Mesh());
+    std::swap(scene.meshes[0], mesh);
+    SceneInstance instance;
+    instance.mesh = 0;
+    instance.transform = glm::mat4(1.0f);
+    scene.instances.push_back(instance);
+
+    // One untransformed instance spans exactly the mesh
+    scene.model_size = scene.meshes[0].model_size;
+    scene.model_center = scene.meshes[0].model_center;
+    scene.bounds_min = scene.meshes[0].bounds_min;
+    scene.bounds_max = scene.meshes[0].bounds_max;
+    scene.bounding_radius = scene.meshes[0].bounding_radius;
+}
+
+void calculate_scene_bounds(Scene &scene) {
+    bool empty = true;
+    glm::vec3 low(0.0f), high(0.0f);
+    for (auto const &instance : scene.instances) {
+        Mesh const &mesh = scene.meshes[instance.mesh];
+        if (mesh.indices.empty()) {
+            continue;
+        }
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec4 const point((corner & 1) ? mesh.bounds_max.x : mesh.bounds_min.x,
+                                  (corner & 2) ? mesh.bounds_max.y : mesh.bounds_min.y,
+                                  (corner & 4) ? mesh.bounds_max.z : mesh.bounds_min.z, 1.0f);
+            glm::vec3 const moved(instance.transform * point);
+            low = empty ? moved : glm::min(low, moved);
+            high = empty ? moved : glm::max(high, moved);
+            empty = false;
+        }
+    }
+
+    scene.bounds_min = low;
+    scene.bounds_max = high;
+    glm::vec3 const size = high - low;
+    scene.model_size = std::max(size.x, std::max(size.y, size.z));
+    scene.model_center = (low + high) * 0.5f;
+
+    // Each mesh sphere moved into place, scaled by the transform's largest axis
+    scene.bounding_radius = 0.0f;
+    for (auto const &instance : scene.instances) {
+        Mesh const &mesh = scene.meshes[instance.mesh];
+        if (mesh.indices.empty()) {
+            continue;
+        }
+        glm::vec3 const center(instance.transform * glm::vec4(mesh.model_center, 1.0f));
+        float scale = 0.0f;
+        for (int axis = 0; axis < 3; axis++) {
+            scale = std::max(scale, glm::length(glm::vec3(instance.transform[axis])));
+        }
+        scene.bounding_radius = std::max(scene.bounding_radius,
+                                         glm::length(center - scene.model_center) + mesh.bounding_radius * scale);
+    }
+}
+
+void scene_mesh_transforms(Scene const &scene, uint32_t mesh, std::vector<glm::mat4> &transforms) {
+    transforms.clear();
+    for (auto const &instance : scene.instances) {
+        if (instance.mesh == mesh) {
+            transforms.push_back(instance.transform);
+        }
+    }
+}
+
+float scene_mesh_distance(Scene const &scene, uint32_t mesh, glm::vec3 const &point) {
+    bool found = false;
+    float closest = 0.0f;
+    glm::vec4 const center(scene.meshes[mesh].model_center, 1.0f);
+    for (auto const &instance : scene.instances) {
+        if (instance.mesh != mesh) {
+            continue;
+        }
+        float const distance = glm::length(glm::vec3(instance.transform * center) - point);
+        closest = found ? std::min(closest, distance) : distance;
+        found = true;
+    }
+    return closest;
+}
+
+static bool parse_scene_line(std::string const &line, std::string &model_path, glm::mat4 &transform) {
+    std::istringstream stream(line);
+    if (!(stream >> model_path)) {
+        return false;
+    }
+    float values[12];
+    size_t count = 0;
+    while (count < 12 && stream >> values[count]) {
+        count++;
+    }
+    std::string rest;
+    if (!stream.eof() && (stream.clear(), stream >> rest)) {
+        return false;
+    }
+
+    transform = glm::mat4(1.0f);
+    if (count == 3) {
+        transform[3] = glm::vec4(values[0], values[1], values[2], 1.0f);
+        return true;
+    }
+    if (count == 12) {
+        // Rows in the file, glm matrices are indexed by column
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++) {
+                transform[column][row] = values[4 * row + column];
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+static std::string resolve_scene_path(std::string const &scene_path, std::string const &model_path) {
+    if (model_path.empty() || model_path[0] == '/') {
+        return model_path;
+    }
+    size_t const slash = scene_path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return model_path;
+    }
+    return scene_path.substr(0, slash + 1) + model_path;
+}
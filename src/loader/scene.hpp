@@ -0,0 +1,85 @@
+#ifndef SCENE_H_
+#define SCENE_H_
+
+#include "../includes/common.h"
+#include "loader.hpp"
+#include "mesh.hpp"
+
+struct SceneInstance {
+    // Index into Scene::meshes
+    uint32_t mesh;
+    glm::mat4 transform;
+};
+
+/**
+ * @brief Meshes placed in the world by instances
+ *
+ * Every model file is loaded once, however many instances use it.
+ */
+struct Scene {
+    std::vector<std::string> mesh_paths;
+    std::vector<Mesh> meshes;
+    std::vector<SceneInstance> instances;
+    float model_size = 0.0f;
+    glm::vec3 model_center = glm::vec3(0.0f);
+    glm::vec3 bounds_min = glm::vec3(0.0f);
+    glm::vec3 bounds_max = glm::vec3(0.0f);
+    // Bounding sphere around model_center
+    float bounding_radius = 0.0f;
+};
+
+/**
+ * @brief Loads an assembly listing model files and where to place them
+ *
+ * Each line holds a model path followed by either a translation (3 numbers)
+ * or the rows of a 3x4 affine matrix (12 numbers). Relative paths start at
+ * the scene file's directory, and lines starting with '#' are comments.
+ *
+ * @param path Path to the .scene file
+ * @param scene Output scene, replaced entirely
+ * @param flags Bitmask of LoadFlags used for every model
+ * @param control Optional progress/cancel state shared with another thread
+ * @param stats Optional per-stage load stats, summed over every model
+ * @return Returns false if the file could not be read or a line is invalid
+ */
+bool load_scene(std::string const &path, Scene &scene, unsigned flags = 0, LoadControl *control = nullptr,
+                LoadStats *stats = nullptr);
+
+/**
+ * @brief Wraps a single mesh into a scene with one untransformed instance
+ *
+ * @param path Path the mesh was loaded from
+ * @param mesh Mesh to move into the scene
+ * @param scene Output scene, replaced entirely
+ */
+void make_mesh_scene(std::string const &path, Mesh &mesh, Scene &scene);
+
+/**
+ * @brief Sets the scene bounds, size, center and bounding radius from its instances
+ *
+ * @param scene Scene to measure
+ */
+void calculate_scene_bounds(Scene &scene);
+
+/**
+ * @brief Collects the transforms of every instance of one mesh
+ *
+ * @param scene Scene to search
+ * @param mesh Index into scene.meshes
+ * @param transforms Output transforms, in instance order
+ */
+void scene_mesh_transforms(Scene const &scene, uint32_t mesh, std::vector<glm::mat4> &transforms);
+
+/**
+ * @brief Distance from a point to the closest instance of one mesh
+ *
+ * Measured to the center of each transformed mesh, as select_mesh_lod expects.
+ *
+ * @param scene Scene to search
+ * @param mesh Index into scene.meshes
+ * @param point Point in world space, usually the camera
+ * @return Returns the distance, or 0 if the mesh has no instances
+ */
+float scene_mesh_distance(Scene const &scene, uint32_t mesh, glm::vec3 const &point);
+
+#endif  // SCENE_H_
@@ -12,7 +12,10 @@ static inline ImGui::FileBrowser init_filebrowser();
 static inline void framebuffer_size_callback(GLFWwindow *window, int width,
                                              int height);
 static inline void glfw_error_callback(int error, const char *description);
-static inline void calculate_camera_position(glm::vec3 &camera_position, float const distance_to_center, float const yaw_angle, float const pitch_angle);
+static inline void draw_frame_timings(FrameProfiler &profiler, int &record_frames);
+static inline void draw_load_stats(LoadStats const &stats);
+static inline bool profile_loads(int argc, char **argv);
+static inline void wait_for_redraw(AsyncModelLoader &loader, int &redraw_frames);
 
 int main(int const argc, char **argv)
 {
@@ -23,7 +26,42 @@ int main(int const argc, char **argv)
     }
     printf("\n");
 
-    srand(time(0));
+    if (argc > 1 && std::string(argv[1]) == "--thumbnails") {
+#ifdef HEADLESS_THUMBNAILS
+        ThumbnailOptions options;
+        std::vector<std::string> paths;
+        if (!parse_thumbnail_args(argc - 2, argv + 2, options, paths)) {
+            printf("Usage: %s --thumbnails <output dir> [--size WxH] [--presets a,b,...] [--list file] [--cpu] "
+                   "[--color-by-face] [files...]\n",
+                   argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        exit(render_thumbnails(paths, options) ? EXIT_SUCCESS : EXIT_FAILURE);
+#else
+        printf("Headless thumbnails are only built on Linux\n");
+        exit(EXIT_FAILURE);
+#endif
+    }
+    if (argc > 1 && std::string(argv[1]) == "--profile-load") {
+        if (argc < 3) {
+            printf("Usage: %s --profile-load [files...]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        exit(profile_loads(argc - 2, argv + 2) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--generate") {
+        GeneratorOptions options;
+        std::string path;
+        if (!parse_generator_args(argc - 2, argv + 2, options, path)) {
+            printf("Usage: %s --generate <sphere|terrain|soup> <triangles> <output.obj|output_LOD1.model> "
+                   "[--seed N] [--noise X]\n",
+                   argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        exit(write_generated_mesh(path, options) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     init_glfw();
     GLFWwindow *window = create_window();
 
@@ -32,17 +70,23 @@ int main(int const argc, char **argv)
     glEnable(GL_DEPTH_TEST);
     glDepthFunc(GL_LESS);
 
-    // Init VAO (VAO is an array of data buffers used by OpenGL)
-    GLuint VertexArrayID;
-    glGenVertexArrays(1, &VertexArrayID);
-    glBindVertexArray(VertexArrayID);
-
     init_imgui(window);
     ImGui::FileBrowser fileDialog = init_filebrowser();
 
     // Imgui Defaults
     ImVec4 bg_color = ImVec4(0.29f, 0.29f, 0.29f, 1.00f);
     int draw_type = GL_TRIANGLES;
+    int color_mode = COLOR_BY_VERTEX;
+    bool half_positions = false;
+    bool optimize_order = false;
+    bool build_lods = false;
+    bool build_clusters = false;
+    // Sleep in glfwWaitEvents until input, a finished load or a recording needs a frame
+    bool render_on_demand = true;
+    int redraw_frames = REDRAW_FRAMES;
+    bool cull_clusters = true;
+    bool cull_backfaces = false;
+    float lod_pixel_error = LOD_PIXEL_ERROR;
     float fov = 45.0f, near = 0.1f, far = 100.0f, view_distance = 0.f, yaw_camera_angle = 0.f, pitch_camera_angle = 90.f;
     glm::vec3 camera_position;
 
@@ -53,95 +97,236 @@ int main(int const argc, char **argv)
     glUseProgram(programID);
 
     GLuint MatrixID = glGetUniformLocation(programID, "MVP");
+    GLuint ColorModeID = glGetUniformLocation(programID, "colorMode");
+    GLint FirstFaceID = glGetUniformLocation(programID, "firstFace");
 
-    // Vertices for loading
-    #if 1
-    std::string path = "/home/llama/Documents/PureParts/Parts/SWINGARM/SWINGARM_03_LOD1.model";
-    #else
-    std::string path = "/home/llama/Documents/PureParts/Parts/SWINGARM/SWINGARM_01_LOD3.model";
-    #endif
+    // Without a path the viewer starts empty until a file is opened
+    std::string path;
+    if (argc > 1) {
+        path = argv[1];
+    }
+    // Models are loaded in the background, the current mesh keeps drawing meanwhile
+    AsyncModelLoader model_loader;
+    model_loader.on_finished = glfwPostEmptyEvent;
+    start_async_loader(model_loader);
+    if (!path.empty()) {
+        request_model_load(model_loader, path);
+    }
+
+    // Single models are shown as a scene with one instance
+    Scene scene;
     size_t faces_count = 0;
+    size_t edges_count = 0;
     size_t vertices_count = 0;
-    float model_size = 0;
-    glm::vec3 model_center;
-    std::vector<glm::vec3> vertices;
-    load_model(path, vertices, faces_count, vertices_count, model_size, model_center);
-    view_distance = model_size * 1.5f;
+    float model_size = scene.model_size;
+    glm::vec3 model_center = scene.model_center;
+    float acmr = 0.0f;
+    std::vector<MeshletRange> visible_ranges;
+    std::vector<glm::mat4> transforms;
+    size_t visible_meshlets = 0, total_meshlets = 0, draw_calls = 0, drawn_faces = 0, lod = 0;
+    LoadStats load_stats;
+
+    // VAO and buffers per unique mesh, only uploaded when it changes
+    std::vector<GpuMesh> gpu_meshes;
+
+    // CPU time per stage of the frame, and GPU time of the draw calls
+    FrameProfiler profiler;
+    GpuTimer draw_timer;
+    create_gpu_timer(draw_timer, STAGE_GPU_DRAW);
+    int record_frames = 120;
 
-    // Vertex buffer to load data into it in the main loop
-    GLuint vertex_buffer;
-    glGenBuffers(1, &vertex_buffer);
+    glEnable(GL_PROGRAM_POINT_SIZE);
 
-    GLfloat *color_buffer_data = new GLfloat[vertices.size() * 3 * 3];
-    generate_random_colors(color_buffer_data, vertices.size());
+    while (!glfwWindowShouldClose(window)) {
+        begin_profile_frame(profiler);
+        poll_gpu_timer(draw_timer, profiler);
 
-    // Color buffer to load colors
-    GLuint color_buffer;
-    glGenBuffers(1, &color_buffer);
+        // Take over finished loads, GL uploads must happen on this thread
+        {
+            ScopedProfileTimer upload_timer(profiler, STAGE_UPLOAD);
+            ModelLoadResult loaded;
+            while (poll_model_load(model_loader, loaded)) {
+                if (loaded.scene.instances.empty()) {
+                    if (loaded.mesh.indices.empty()) {
+                        printf("Could not load model: '%s'\n", loaded.path.c_str());
+                        continue;
+                    }
+                    make_mesh_scene(loaded.path, loaded.mesh, loaded.scene);
+                }
+                path = loaded.path;
+                load_stats = loaded.stats;
+                scene = std::move(loaded.scene);
+                model_size = scene.model_size;
+                model_center = scene.model_center;
+                // Far enough for the bounding sphere to fit the vertical field of view
+                view_distance = std::max(scene.bounding_radius, 1e-6f) / std::sin(glm::radians(fov) * 0.5f);
+
+                // Counts are per instance, ACMR is averaged over the unique meshes
+                faces_count = 0;
+                edges_count = 0;
+                vertices_count = 0;
+                for (auto const &instance : scene.instances) {
+                    faces_count += scene.meshes[instance.mesh].faces_count;
+                    edges_count += scene.meshes[instance.mesh].edges_count;
+                    vertices_count += scene.meshes[instance.mesh].vertices_count;
+                }
+                float cache_misses = 0.0f;
+                size_t triangles = 0;
+                for (auto const &mesh : scene.meshes) {
+                    cache_misses += compute_acmr(mesh.indices, mesh_vertex_count(mesh)) * (mesh.indices.size() / 3);
+                    triangles += mesh.indices.size() / 3;
+                }
+                acmr = triangles == 0 ? 0.0f : cache_misses / triangles;
 
-    glEnable(GL_PROGRAM_POINT_SIZE);
+                set_gpu_scene(gpu_meshes, scene);
+            }
+            // Only does work on the frame after a load
+            for (uint32_t i = 0; i < scene.meshes.size(); i++) {
+                sync_gpu_mesh(gpu_meshes[i], scene.meshes[i]);
+            }
+        }
+
+        {
+            ScopedProfileTimer input_timer(profiler, STAGE_INPUT);
+            process_input(window);
+        }
+        {
+            ScopedProfileTimer imgui_timer(profiler, STAGE_IMGUI);
+            imgui_preprocess();
+        }
+
+        // Draw calls are timed on the GPU too, the result arrives a few frames later
+        double const draw_start = profile_now_ms(profiler);
+        begin_gpu_timer(draw_timer, profiler);
 
-    while (!glfwWindowShouldClose(window)) {
         // Background color
         glClearColor(bg_color.x * bg_color.w, bg_color.y * bg_color.w,
                      bg_color.z * bg_color.w, bg_color.w);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        process_input(window);
-        imgui_preprocess();
-
-        // Load colors
-        glBindBuffer(GL_ARRAY_BUFFER, color_buffer);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * 3 * 3,
-                     color_buffer_data, GL_STATIC_DRAW);
-
-        // Load vertices
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3),
-                     &vertices[0], GL_STATIC_DRAW);
-
         // Projection & View
         calculate_camera_position(camera_position, view_distance, yaw_camera_angle, pitch_camera_angle);
         glm::mat4 MVP = compute_mvp(fov, camera_position + model_center, model_center, near, far);
 
         // Send our transformation to the currently bound shader,
         glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-
-        //  Enable to use attributes in a vertex shader
-        glEnableVertexAttribArray(0);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        glEnableVertexAttribArray(1);
-        glBindBuffer(GL_ARRAY_BUFFER, color_buffer);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void *)0);
-
-        // Drawing GL_LINE_STRIP GL_TRIANGLES
-        glDrawArrays(draw_type, 0, vertices.size());
-
-        // Disable to avoid OpenGL reading from arrays bound to an invalid ptr
-        glDisableVertexAttribArray(0);
-        glDisableVertexAttribArray(1);
+        glUniform1i(ColorModeID, color_mode);
+
+        int viewport_width = 0, viewport_height = 0;
+        glfwGetFramebufferSize(window, &viewport_width, &viewport_height);
+        glm::vec3 const camera_world = camera_position + model_center;
+
+        // One draw call per unique mesh covering all of its instances, or one per culled range
+        visible_meshlets = 0;
+        total_meshlets = 0;
+        draw_calls = 0;
+        drawn_faces = 0;
+        for (uint32_t i = 0; i < scene.meshes.size(); i++) {
+            Mesh const &mesh = scene.meshes[i];
+            GpuMesh &gpu_mesh = gpu_meshes[i];
+
+            // Coarsest level that stays within the pixel error for the closest instance
+            size_t const mesh_lod = select_mesh_lod(mesh, scene_mesh_distance(scene, i, camera_world), fov,
+                                                    static_cast<float>(viewport_height), lod_pixel_error);
+            if (i == 0) {
+                lod = mesh_lod;
+            }
+            size_t const lod_indices = mesh_lod == 0 ? mesh.indices.size() : mesh.lods[mesh_lod - 1].indices.size();
+            total_meshlets += mesh.meshlets.size() * gpu_mesh.instance_count;
+
+            // Drawing GL_LINES GL_TRIANGLES GL_POINTS
+            if (draw_type == GL_LINES) {
+                // The wireframe is built from the full mesh, each edge drawn once
+                visible_meshlets += mesh.meshlets.size() * gpu_mesh.instance_count;
+                draw_gpu_mesh_edges(gpu_mesh);
+                drawn_faces += mesh.faces_count * gpu_mesh.instance_count;
+                draw_calls++;
+            } else if (mesh_lod == 0 && cull_clusters && !mesh.meshlets.empty() && gpu_mesh.instance_count == 1) {
+                // Culling works in mesh space, so the instance transform goes into both inputs
+                scene_mesh_transforms(scene, i, transforms);
+                Frustum frustum;
+                extract_frustum(MVP * transforms[0], frustum);
+                glm::vec3 const camera_mesh(glm::inverse(transforms[0]) * glm::vec4(camera_world, 1.0f));
+                visible_meshlets += cull_meshlets(mesh.meshlets, frustum, camera_mesh, cull_backfaces,
+                                                  visible_ranges);
+                draw_gpu_mesh_ranges(gpu_mesh, draw_type, FirstFaceID, visible_ranges);
+                for (auto const &range : visible_ranges) {
+                    drawn_faces += range.index_count / 3;
+                }
+                draw_calls += visible_ranges.size();
+            } else {
+                visible_meshlets += mesh.meshlets.size() * gpu_mesh.instance_count;
+                draw_gpu_mesh(gpu_mesh, draw_type, FirstFaceID, mesh_lod);
+                drawn_faces += lod_indices / 3 * gpu_mesh.instance_count;
+                draw_calls++;
+            }
+        }
+        end_gpu_timer(draw_timer);
+        add_profile_sample(profiler, STAGE_DRAW, profiler.frame, draw_start, profile_now_ms(profiler) - draw_start);
 
         // Main GUI window
         {
+            ScopedProfileTimer imgui_timer(profiler, STAGE_IMGUI);
+            bool reload_model = false;
             if (ImGui::Begin("Main Menu")) {
                 if (ImGui::Button("Open file"))
                     fileDialog.Open();
 
                 ImGui::SameLine();
                 ImGui::Text("%s", get_filename(path).c_str());
+                std::string loading_path;
+                float load_progress = 0.0f;
+                if (model_load_in_progress(model_loader, loading_path, load_progress)) {
+                    ImGui::ProgressBar(load_progress, ImVec2(-80.0f, 0.0f), get_filename(loading_path).c_str());
+                    ImGui::SameLine();
+                    if (ImGui::Button("Cancel##Load"))
+                        cancel_model_loads(model_loader);
+                }
                 ImGui::Text("Vertices: %zu", vertices_count);
                 ImGui::SameLine();
-                ImGui::Text("Edges: %zu", faces_count);
+                ImGui::Text("Faces: %zu", faces_count);
+                ImGui::SameLine();
+                ImGui::Text("Edges: %zu", edges_count);
                 ImGui::SameLine();
                 ImGui::Text("ModelSize: %.2f", model_size);
+                ImGui::SameLine();
+                ImGui::Text("ACMR: %.2f", acmr);
+                ImGui::Text("Meshes: %zu", scene.meshes.size());
+                ImGui::SameLine();
+                ImGui::Text("Instances: %zu", scene.instances.size());
+                ImGui::SameLine();
+                ImGui::Text("Draw calls: %zu", draw_calls);
+                ImGui::Checkbox("Render on demand", &render_on_demand);
                 ImGui::ColorEdit4("Color", (float *)&bg_color);
                 ImGui::RadioButton("GL_TRIANGLES", &draw_type, GL_TRIANGLES);
                 ImGui::SameLine();
-                ImGui::RadioButton("GL_LINE_STRIP", &draw_type, GL_LINE_STRIP);
+                ImGui::RadioButton("Wireframe (GL_LINES)", &draw_type, GL_LINES);
                 ImGui::SameLine();
                 ImGui::RadioButton("GL_POINTS", &draw_type, GL_POINTS);
+                ImGui::RadioButton("Color by vertex", &color_mode, COLOR_BY_VERTEX);
+                ImGui::SameLine();
+                ImGui::RadioButton("Color by face", &color_mode, COLOR_BY_FACE);
+                if (ImGui::Checkbox("Half float positions (.model)", &half_positions))
+                    reload_model = true;
+                if (ImGui::Checkbox("Optimize vertex order", &optimize_order))
+                    reload_model = true;
+                if (ImGui::Checkbox("Build LODs", &build_lods))
+                    reload_model = true;
+                if (ImGui::Checkbox("Build meshlets", &build_clusters))
+                    reload_model = true;
+                if (total_meshlets != 0) {
+                    ImGui::SameLine();
+                    ImGui::Text("Meshlets: %zu/%zu", visible_meshlets, total_meshlets);
+                    ImGui::Checkbox("Frustum culling", &cull_clusters);
+                    ImGui::SameLine();
+                    ImGui::Checkbox("Back-face cone culling", &cull_backfaces);
+                }
+                if (!scene.meshes.empty() && !scene.meshes[0].lods.empty()) {
+                    ImGui::SameLine();
+                    ImGui::Text("LOD: %zu/%zu (%zu faces drawn)", lod, scene.meshes[0].lods.size(), drawn_faces);
+                    ImGui::DragFloat("LOD pixel error", &lod_pixel_error, 0.05f, 0.0f, 100.0f, "%.2f");
+                }
+                draw_load_stats(load_stats);
                 
                 if (ImGui::Button("Reset##ModelCenter")) {
                     model_center.x = 0.0f;
@@ -175,54 +360,81 @@ int main(int const argc, char **argv)
             }
             ImGui::End();
 
+            draw_frame_timings(profiler, record_frames);
+
             fileDialog.Display();
 
+            std::string load_path = path;
             if (fileDialog.HasSelected()) {
-                path = fileDialog.GetSelected();
-
-                vertices.clear();
-                faces_count = 0;
-                vertices_count = 0;
-
-                load_model(path.c_str(), vertices, faces_count, vertices_count, model_size, model_center);
-                view_distance = model_size * 1.5f;
-
-
-                delete[] color_buffer_data;
-                color_buffer_data = new GLfloat[vertices.size() * 3 * 3];
-                generate_random_colors(color_buffer_data, vertices.size());
-
+                load_path = fileDialog.GetSelected();
                 fileDialog.ClearSelected();
+                reload_model = true;
+            }
+
+            // Option changes reload the current file, if there is one
+            if (reload_model && !load_path.empty()) {
+                unsigned const flags = (half_positions ? LOAD_HALF_POSITIONS : 0) | (optimize_order ? LOAD_OPTIMIZE : 0) |
+                                       (build_lods ? LOAD_LODS : 0) | (build_clusters ? LOAD_MESHLETS : 0);
+                request_model_load(model_loader, load_path, flags);
             }
         }
 
-        imgui_postprocess();
+        {
+            ScopedProfileTimer imgui_timer(profiler, STAGE_IMGUI);
+            imgui_postprocess();
+        }
+        {
+            ScopedProfileTimer swap_timer(profiler, STAGE_SWAP);
+            glfwSwapBuffers(window);
+        }
+        {
+            ScopedProfileTimer input_timer(profiler, STAGE_INPUT);
+            glfwPollEvents();
+        }
+        end_profile_frame(profiler);
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Idle time is spent outside the profiled frame, recordings need consecutive frames
+        if (render_on_demand && profiler.frame >= profiler.record_end) {
+            wait_for_redraw(model_loader, redraw_frames);
+        }
     }
 
+    stop_async_loader(model_loader);
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glDeleteBuffers(1, &color_buffer);
-    glDeleteBuffers(1, &vertex_buffer);
+    for (auto &gpu_mesh : gpu_meshes) {
+        destroy_gpu_mesh(gpu_mesh);
+    }
+    destroy_gpu_timer(draw_timer);
     glDeleteProgram(programID);
-    glDeleteVertexArrays(1, &VertexArrayID);
 
     glfwTerminate();
-
-    delete[] color_buffer_data;
     exit(EXIT_SUCCESS);
 }
 
-void calculate_camera_position(glm::vec3 &camera_position, float const distance_to_center, float const yaw_angle, float const pitch_angle) {
-    auto const theta = glm::radians(pitch_angle);
-    auto const phi = glm::radians(yaw_angle);
-    camera_position.x = distance_to_center * glm::cos(phi) * glm::sin(theta);
-    camera_position.z = distance_to_center * glm::sin(phi) * glm::sin(theta);
-    camera_position.y = distance_to_center * glm::cos(theta);
+/**
+ * @brief Sleeps once the frames owed to the last wake up are drawn
+ *
+ * Input, window and empty events (posted by the loader when a load ends)
+ * wake the loop, which then draws REDRAW_FRAMES frames. A running load
+ * wakes it periodically too, to move the progress bar.
+ *
+ * @param loader Model loader of the window
+ * @param redraw_frames Frames left to draw before sleeping
+ */
+static inline void wait_for_redraw(AsyncModelLoader &loader, int &redraw_frames) {
+    if (--redraw_frames > 0)
+        return;
+    std::string path;
+    float progress = 0.0f;
+    if (model_load_in_progress(loader, path, progress))
+        glfwWaitEventsTimeout(LOAD_PROGRESS_INTERVAL);
+    else
+        glfwWaitEvents();
+    redraw_frames = REDRAW_FRAMES;
 }
 
 /**
@@ -235,6 +447,97 @@ static inline void glfw_error_callback(int error, const char *description) {
     fprintf(stderr, "Glfw Error %d: %s\n", error, description);
 }
 
+/**
+ * @brief Rolling per-stage timings, and recording of a trace to export
+ *
+ * @param profiler Profiler of the main loop
+ * @param record_frames Number of frames the next recording covers
+ */
+static inline void draw_frame_timings(FrameProfiler &profiler, int &record_frames) {
+    if (ImGui::Begin("Frame timings")) {
+        for (unsigned stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+            float average = 0.0f, worst = 0.0f;
+            profile_stage_summary(profiler, stage, average, worst);
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "avg %.2f ms, max %.2f ms", average, worst);
+            // The ring starts at its oldest frame, so the newest is drawn on the right
+            ImGui::PlotHistogram(profile_stage_name(stage), profiler.history[stage], PROFILE_HISTORY,
+                                 static_cast<int>(profiler.history_next), overlay, 0.0f,
+                                 std::max(worst, 1.0f), ImVec2(0.0f, 40.0f));
+        }
+
+        ImGui::InputInt("Frames", &record_frames);
+        record_frames = std::max(record_frames, 1);
+        ImGui::SameLine();
+        if (ImGui::Button("Record")) {
+            start_profile_recording(profiler, static_cast<size_t>(record_frames));
+        }
+        if (profiler.frame < profiler.record_end) {
+            ImGui::Text("Recording %llu/%llu frames",
+                        static_cast<unsigned long long>(profiler.frame - profiler.record_begin),
+                        static_cast<unsigned long long>(profiler.record_end - profiler.record_begin));
+        } else if (!profiler.recorded.empty()) {
+            if (ImGui::Button("Save trace (JSON)") && write_chrome_trace(profiler, "frame_trace.json"))
+                printf("Saved %zu events to frame_trace.json\n", profiler.recorded.size());
+            ImGui::SameLine();
+            if (ImGui::Button("Save CSV") && write_profile_csv(profiler, "frame_trace.csv"))
+                printf("Saved %zu events to frame_trace.csv\n", profiler.recorded.size());
+        }
+    }
+    ImGui::End();
+}
+
+/**
+ * @brief Per-stage times of the last load, in a collapsed section
+ *
+ * @param stats Stats of the model on screen
+ */
+static inline void draw_load_stats(LoadStats const &stats) {
+    char header[64];
+    snprintf(header, sizeof(header), "Load: %.1f ms###LoadStats", stats.total_ms);
+    if (!ImGui::CollapsingHeader(header))
+        return;
+    if (stats.cache_hits != 0)
+        ImGui::Text("%zu of %zu files from the mesh cache", stats.cache_hits, stats.files);
+    for (unsigned stage = 0; stage < LOAD_STAGE_COUNT; stage++) {
+        LoadStageStats const &stage_stats = stats.stages[stage];
+        if (stage_stats.ms == 0.0 && stage_stats.bytes == 0)
+            continue;
+        float const share = stats.total_ms > 0.0 ? static_cast<float>(stage_stats.ms / stats.total_ms) : 0.0f;
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.2f ms, %.1f MB", stage_stats.ms, stage_stats.bytes / (1024.0 * 1024.0));
+        ImGui::ProgressBar(share, ImVec2(-120.0f, 0.0f), overlay);
+        ImGui::SameLine();
+        ImGui::Text("%s", load_stage_name(stage));
+    }
+}
+
+/**
+ * @brief Loads every file without the mesh cache and prints where the time went
+ *
+ * @param argc Number of files
+ * @param argv Model or .scene paths
+ * @return Returns false if any file failed to load
+ */
+static inline bool profile_loads(int argc, char **argv) {
+    bool ok = true;
+    for (int i = 0; i < argc; i++) {
+        std::string const path = argv[i];
+        std::string const extension = get_file_extension(path);
+        LoadStats stats;
+        if (extension == "scene") {
+            Scene scene;
+            ok = load_scene(path, scene, LOAD_NO_CACHE, nullptr, &stats) && ok;
+        } else {
+            Mesh mesh;
+            load_model(path, mesh, LOAD_NO_CACHE, nullptr, &stats);
+            ok = !mesh.indices.empty() && ok;
+        }
+        print_load_stats(path, stats);
+    }
+    return ok;
+}
+
 /**
  * @brief Setting up resize callback
  *
@@ -298,7 +601,7 @@ static inline void init_imgui(GLFWwindow *window) {
 static inline ImGui::FileBrowser init_filebrowser() {
     ImGui::FileBrowser fileDialog;
     fileDialog.SetTitle("Select a 3d model to view:");
-    fileDialog.SetTypeFilters({".obj", ".model"});
+    fileDialog.SetTypeFilters({".obj", ".model", ".scene"});
     return fileDialog;
 }
 
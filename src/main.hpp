@@ -4,7 +4,19 @@
 #include "common.h"
 #include "shader/shader.hpp"
 #include "loader/loader.hpp"
+#include "loader/async_loader.hpp"
+#include "loader/mesh_optimize.hpp"
+#include "loader/mesh_simplify.hpp"
+#include "loader/meshlet.hpp"
+#include "loader/scene.hpp"
+#include "loader/mesh_generator.hpp"
+#include "render/gpu_mesh.hpp"
+#include "render/gpu_timer.hpp"
+#ifdef HEADLESS_THUMBNAILS
+#include "render/thumbnail.hpp"
+#endif
 #include "utils/utils.hpp"
+#include "utils/profiler.hpp"
 
 #include <imgui.h>
 #include <imfilebrowser.h>
@@ -14,4 +26,10 @@
 
 const char PROGRAM_TITLE[] = "3d Model Viewer";
 
+// Frames drawn after every wake up when rendering on demand, ImGui needs a
+// couple to settle hover states and window layout
+constexpr int REDRAW_FRAMES = 3;
+// Seconds between progress bar updates while a load runs in an idle window
+constexpr double LOAD_PROGRESS_INTERVAL = 0.1;
+
 #endif  // MAIN_HPP_
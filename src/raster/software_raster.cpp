@@ -0,0 +1,434 @@
+#include "software_raster.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include "../loader/half_float.hpp"
+#include "../loader/mesh_simplify.hpp"
+#include "../utils/parallel.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Clip space vertex with its color, before the perspective divide
+struct ClipVertex {
+    glm::vec4 position;
+    glm::vec3 color;
+};
+
+/**
+ * @brief Triangle in window coordinates, counter-clockwise
+ */
+struct RasterTriangle {
+    glm::vec2 position[3];
+    float depth[3];
+    // 1/w and color/w, interpolated linearly for perspective correct colors
+    float inv_w[3];
+    glm::vec3 color[3];
+    // Inclusive pixel bounds
+    int min_x, min_y, max_x, max_y;
+};
+
+// Triangles set up by one task, and which tiles each of them touches
+struct RasterBins {
+    std::vector<RasterTriangle> triangles;
+    std::vector<std::vector<uint32_t>> tiles;
+};
+
+// Rectangle of pixels, max exclusive
+struct RasterRect {
+    int min_x, min_y, max_x, max_y;
+};
+
+static void draw_raster_ranges(RasterTarget &target, Mesh const &mesh, std::vector<uint32_t> const &indices,
+                               uint32_t first_face, std::vector<MeshletRange> const &ranges, glm::mat4 const &mvp,
+                               std::vector<glm::mat4> const &transforms, int color_mode, unsigned thread_count);
+static uint32_t hash_id(uint32_t x);
+static glm::vec3 hash_color(uint32_t id);
+static void setup_triangle(ClipVertex const *vertices, RasterTarget const &target, int tiles_x, RasterBins &bins);
+static void bin_triangle(ClipVertex const &a, ClipVertex const &b, ClipVertex const &c, RasterTarget const &target,
+                         int tiles_x, RasterBins &bins);
+static void raster_triangle(RasterTriangle const &triangle, RasterRect const &tile, RasterTarget &target);
+static void shade_pixel(RasterTriangle const &triangle, float const *weights, float inv_area, uint8_t *color);
+
+void resize_raster_target(RasterTarget &target, int width, int height) {
+    target.width = width;
+    target.height = height;
+    target.color.resize(static_cast<size_t>(width) * height * 3);
+    target.depth.resize(static_cast<size_t>(width) * height);
+}
+
+void clear_raster_target(RasterTarget &target, glm::vec3 const &color) {
+    // Same rounding as the conversion to a normalized framebuffer
+    uint8_t const rgb[3] = {static_cast<uint8_t>(glm::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f),
+                            static_cast<uint8_t>(glm::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f),
+                            static_cast<uint8_t>(glm::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f)};
+    for (size_t i = 0; i < target.color.size(); i += 3) {
+        target.color[i + 0] = rgb[0];
+        target.color[i + 1] = rgb[1];
+        target.color[i + 2] = rgb[2];
+    }
+    std::fill(target.depth.begin(), target.depth.end(), 1.0f);
+}
+
+void draw_raster_mesh(RasterTarget &target, Mesh const &mesh, glm::mat4 const &mvp,
+                      std::vector<glm::mat4> const &transforms, int color_mode, size_t lod, unsigned thread_count) {
+    if (lod > mesh.lods.size()) {
+        return;
+    }
+    std::vector<uint32_t> const &indices = lod == 0 ? mesh.indices : mesh.lods[lod - 1].indices;
+    MeshletRange whole;
+    whole.first_index = 0;
+    whole.index_count = static_cast<uint32_t>(indices.size());
+    draw_raster_ranges(target, mesh, indices, mesh_lod_first_face(mesh, lod), std::vector<MeshletRange>(1, whole),
+                       mvp, transforms, color_mode, thread_count);
+}
+
+void draw_raster_mesh_ranges(RasterTarget &target, Mesh const &mesh, glm::mat4 const &mvp,
+                             glm::mat4 const &transform, int color_mode, std::vector<MeshletRange> const &ranges,
+                             unsigned thread_count) {
+    draw_raster_ranges(target, mesh, mesh.indices, 0, ranges, mvp, std::vector<glm::mat4>(1, transform), color_mode,
+                       thread_count);
+}
+
+/**
+ * @brief Draws ranges of one index buffer, shared by both draw functions
+ *
+ * @param indices mesh.indices or one of the lods
+ * @param first_face From mesh_lod_first_face for indices
+ * @param ranges Ranges of indices, whole triangles
+ */
+static void draw_raster_ranges(RasterTarget &target, Mesh const &mesh, std::vector<uint32_t> const &indices,
+                               uint32_t first_face, std::vector<MeshletRange> const &ranges, glm::mat4 const &mvp,
+                               std::vector<glm::mat4> const &transforms, int color_mode, unsigned thread_count) {
+    if (target.width <= 0 || target.height <= 0 || transforms.empty()) {
+        return;
+    }
+    std::vector<glm::vec3> decoded;
+    if (mesh.positions.empty() && !mesh.half_positions.empty()) {
+        decoded.resize(mesh.half_positions.size());
+        convert_float16_to_float32(&mesh.half_positions[0].x, &decoded[0].x, decoded.size() * 3);
+    }
+    std::vector<glm::vec3> const &positions = mesh.positions.empty() ? decoded : mesh.positions;
+    size_t const vertex_count = positions.size();
+    size_t const instance_count = transforms.size();
+    // Triangles before each range, and in all of them at the end
+    std::vector<size_t> range_starts(ranges.size() + 1, 0);
+    for (size_t i = 0; i < ranges.size(); i++) {
+        range_starts[i + 1] = range_starts[i] + ranges[i].index_count / 3;
+    }
+    size_t const triangle_count = range_starts.back();
+    if (vertex_count == 0 || triangle_count == 0) {
+        return;
+    }
+    size_t task_count = thread_count;
+    if (task_count == 0) {
+        task_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Vertex stage, every instance at once
+    std::vector<glm::mat4> instance_mvps(instance_count);
+    for (size_t i = 0; i < instance_count; i++) {
+        instance_mvps[i] = mvp * transforms[i];
+    }
+    std::vector<glm::vec4> clip(vertex_count * instance_count);
+    run_parallel(task_count, [&](size_t task) {
+        size_t const first = clip.size() * task / task_count;
+        size_t const last = clip.size() * (task + 1) / task_count;
+        for (size_t i = first; i < last; i++) {
+            clip[i] = instance_mvps[i / vertex_count] * glm::vec4(positions[i % vertex_count], 1.0f);
+        }
+    });
+
+    // Setup and binning, each task takes a contiguous run of triangles so
+    // reading the bins in task order keeps the draw order within every tile
+    int const tiles_x = (target.width + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    int const tiles_y = (target.height + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+    size_t const tile_count = static_cast<size_t>(tiles_x) * tiles_y;
+    std::vector<RasterBins> bins(task_count);
+    size_t const work_count = triangle_count * instance_count;
+    run_parallel(task_count, [&](size_t task) {
+        RasterBins &task_bins = bins[task];
+        task_bins.tiles.resize(tile_count);
+        size_t const first = work_count * task / task_count;
+        size_t const last = work_count * (task + 1) / task_count;
+        for (size_t work = first; work < last; work++) {
+            size_t const instance = work / triangle_count;
+            size_t const drawn = work % triangle_count;
+            size_t const range = std::upper_bound(range_starts.begin(), range_starts.end(), drawn) -
+                                 range_starts.begin() - 1;
+            uint32_t const triangle =
+                static_cast<uint32_t>(ranges[range].first_index / 3 + (drawn - range_starts[range]));
+            ClipVertex vertices[3];
+            for (int k = 0; k < 3; k++) {
+                uint32_t const index = indices[3 * triangle + k];
+                vertices[k].position = clip[instance * vertex_count + index];
+                // Faces match firstFace + gl_PrimitiveID, which restarts for every instance,
+                // and gl_VertexID is the index
+                vertices[k].color = color_mode == COLOR_BY_FACE
+                                        ? hash_color(first_face + triangle)
+                                        : hash_color(index + static_cast<uint32_t>(instance) * 0x9e3779b9u);
+            }
+            setup_triangle(vertices, target, tiles_x, task_bins);
+        }
+    });
+
+    // Raster stage, threads take whole tiles so no pixel is shared
+    std::atomic<size_t> next_tile(0);
+    run_parallel(std::min(task_count, tile_count), [&](size_t) {
+        for (size_t tile = next_tile++; tile < tile_count; tile = next_tile++) {
+            RasterRect rect;
+            rect.min_x = static_cast<int>(tile % tiles_x) * RASTER_TILE_SIZE;
+            rect.min_y = static_cast<int>(tile / tiles_x) * RASTER_TILE_SIZE;
+            rect.max_x = std::min(rect.min_x + RASTER_TILE_SIZE, target.width);
+            rect.max_y = std::min(rect.min_y + RASTER_TILE_SIZE, target.height);
+            for (auto const &task_bins : bins) {
+                for (uint32_t const triangle : task_bins.tiles[tile]) {
+                    raster_triangle(task_bins.triangles[triangle], rect, target);
+                }
+            }
+        }
+    });
+}
+
+/**
+ * @brief Integer hash (lowbias32), same as the shaders
+ */
+static uint32_t hash_id(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static glm::vec3 hash_color(uint32_t id) {
+    uint32_t const h = hash_id(id);
+    return glm::vec3(float(h & 0xFFu), float((h >> 8) & 0xFFu), float((h >> 16) & 0xFFu)) / 255.0f;
+}
+
+/**
+ * @brief Rejects triangles outside the view and clips the rest to the near plane
+ */
+static void setup_triangle(ClipVertex const *vertices, RasterTarget const &target, int tiles_x, RasterBins &bins) {
+    // Entirely outside one of the side or far planes, the near plane clips below
+    for (int axis = 0; axis < 3; axis++) {
+        bool all_below = true, all_above = true;
+        for (int k = 0; k < 3; k++) {
+            glm::vec4 const &p = vertices[k].position;
+            all_below = all_below && p[axis] < -p.w;
+            all_above = all_above && p[axis] > p.w;
+        }
+        if (all_above || (all_below && axis != 2)) {
+            return;
+        }
+    }
+
+    // Sutherland-Hodgman against z >= -w gives at most 4 vertices
+    float distance[3];
+    int inside = 0;
+    for (int k = 0; k < 3; k++) {
+        distance[k] = vertices[k].position.z + vertices[k].position.w;
+        inside += distance[k] >= 0.0f ? 1 : 0;
+    }
+    if (inside == 3) {
+        bin_triangle(vertices[0], vertices[1], vertices[2], target, tiles_x, bins);
+        return;
+    }
+    if (inside == 0) {
+        return;
+    }
+    ClipVertex polygon[4];
+    int polygon_size = 0;
+    for (int k = 0; k < 3; k++) {
+        int const next = (k + 1) % 3;
+        if (distance[k] >= 0.0f) {
+            polygon[polygon_size++] = vertices[k];
+        }
+        if ((distance[k] >= 0.0f) != (distance[next] >= 0.0f)) {
+            float const t = distance[k] / (distance[k] - distance[next]);
+            polygon[polygon_size].position = glm::mix(vertices[k].position, vertices[next].position, t);
+            polygon[polygon_size].color = glm::mix(vertices[k].color, vertices[next].color, t);
+            polygon_size++;
+        }
+    }
+    for (int k = 1; k + 1 < polygon_size; k++) {
+        bin_triangle(polygon[0], polygon[k], polygon[k + 1], target, tiles_x, bins);
+    }
+}
+
+static void bin_triangle(ClipVertex const &a, ClipVertex const &b, ClipVertex const &c, RasterTarget const &target,
+                         int tiles_x, RasterBins &bins) {
+    ClipVertex const *corners[3] = {&a, &b, &c};
+    RasterTriangle triangle;
+    for (int k = 0; k < 3; k++) {
+        glm::vec4 const &p = corners[k]->position;
+        float const inv_w = 1.0f / p.w;
+        // Viewport and depth range transforms of the default GL state
+        triangle.position[k] = glm::vec2((p.x * inv_w * 0.5f + 0.5f) * target.width,
+                                         (p.y * inv_w * 0.5f + 0.5f) * target.height);
+        triangle.depth[k] = p.z * inv_w * 0.5f + 0.5f;
+        triangle.inv_w[k] = inv_w;
+        triangle.color[k] = corners[k]->color * inv_w;
+    }
+
+    glm::vec2 const &p0 = triangle.position[0], &p1 = triangle.position[1], &p2 = triangle.position[2];
+    float const area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+    // Also drops NaNs from degenerate projections
+    if (!(area > 0.0f) && !(area < 0.0f)) {
+        return;
+    }
+    // Both faces are drawn, flipping the back ones keeps the edge tests positive inside
+    if (area < 0.0f) {
+        std::swap(triangle.position[1], triangle.position[2]);
+        std::swap(triangle.depth[1], triangle.depth[2]);
+        std::swap(triangle.inv_w[1], triangle.inv_w[2]);
+        std::swap(triangle.color[1], triangle.color[2]);
+    }
+
+    // Pixels whose centers fall inside the bounds
+    float const min_x = std::min(p0.x, std::min(p1.x, p2.x)), max_x = std::max(p0.x, std::max(p1.x, p2.x));
+    float const min_y = std::min(p0.y, std::min(p1.y, p2.y)), max_y = std::max(p0.y, std::max(p1.y, p2.y));
+    triangle.min_x = std::max(0, static_cast<int>(std::ceil(std::max(min_x - 0.5f, -1.0f))));
+    triangle.min_y = std::max(0, static_cast<int>(std::ceil(std::max(min_y - 0.5f, -1.0f))));
+    triangle.max_x = std::min(target.width - 1, static_cast<int>(std::floor(std::min(max_x - 0.5f, float(target.width)))));
+    triangle.max_y = std::min(target.height - 1, static_cast<int>(std::floor(std::min(max_y - 0.5f, float(target.height)))));
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+        return;
+    }
+
+    uint32_t const id = static_cast<uint32_t>(bins.triangles.size());
+    bins.triangles.push_back(triangle);
+    for (int ty = triangle.min_y / RASTER_TILE_SIZE; ty <= triangle.max_y / RASTER_TILE_SIZE; ty++) {
+        for (int tx = triangle.min_x / RASTER_TILE_SIZE; tx <= triangle.max_x / RASTER_TILE_SIZE; tx++) {
+            bins.tiles[static_cast<size_t>(ty) * tiles_x + tx].push_back(id);
+        }
+    }
+}
+
+/**
+ * @brief Fills the pixels of one triangle inside one tile
+ *
+ * Pixel centers on an edge belong to the triangle only for top and left
+ * edges, so neighbours sharing that edge never both draw it.
+ */
+static void raster_triangle(RasterTriangle const &triangle, RasterRect const &tile, RasterTarget &target) {
+    int const x0 = std::max(triangle.min_x, tile.min_x), x1 = std::min(triangle.max_x + 1, tile.max_x);
+    int const y0 = std::max(triangle.min_y, tile.min_y), y1 = std::min(triangle.max_y + 1, tile.max_y);
+    if (x0 >= x1 || y0 >= y1) {
+        return;
+    }
+
+    // Edge k is opposite vertex k, E(x, y) = a * x + b * y + c
+    float edge_a[3], edge_b[3], edge_c[3];
+    bool top_left[3];
+    for (int k = 0; k < 3; k++) {
+        glm::vec2 const &from = triangle.position[(k + 1) % 3];
+        glm::vec2 const &to = triangle.position[(k + 2) % 3];
+        edge_a[k] = from.y - to.y;
+        edge_b[k] = to.x - from.x;
+        edge_c[k] = -(edge_a[k] * from.x + edge_b[k] * from.y);
+        // Counter-clockwise with y up: left edges go down, top edges go left
+        top_left[k] = to.y < from.y || (to.y == from.y && to.x < from.x);
+    }
+    float const area = edge_c[0] + edge_a[0] * triangle.position[0].x + edge_b[0] * triangle.position[0].y;
+    float const inv_area = 1.0f / area;
+    float const depth_1 = (triangle.depth[1] - triangle.depth[0]) * inv_area;
+    float const depth_2 = (triangle.depth[2] - triangle.depth[0]) * inv_area;
+
+    for (int y = y0; y < y1; y++) {
+        float const center_y = y + 0.5f;
+        float *depth_row = &target.depth[static_cast<size_t>(y) * target.width];
+        uint8_t *color_row = &target.color[static_cast<size_t>(y) * target.width * 3];
+        float row[3];
+        for (int k = 0; k < 3; k++) {
+            row[k] = edge_a[k] * (x0 + 0.5f) + edge_b[k] * center_y + edge_c[k];
+        }
+#if defined(__SSE2__)
+        __m128 const zero = _mm_setzero_ps();
+        __m128 const lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+        for (int x = x0; x < x1; x += 4) {
+            // Edge values, coverage and depth of 4 pixels at once
+            __m128 const offset = _mm_add_ps(_mm_set1_ps(float(x - x0)), lanes);
+            __m128 weight[3];
+            __m128 covered = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int k = 0; k < 3; k++) {
+                weight[k] = _mm_add_ps(_mm_set1_ps(row[k]), _mm_mul_ps(_mm_set1_ps(edge_a[k]), offset));
+                __m128 const inside = top_left[k] ? _mm_cmpge_ps(weight[k], zero) : _mm_cmpgt_ps(weight[k], zero);
+                covered = _mm_and_ps(covered, inside);
+            }
+            int const count = std::min(4, x1 - x);
+            covered = _mm_and_ps(covered, _mm_cmplt_ps(lanes, _mm_set1_ps(float(count))));
+            __m128 const depth = _mm_add_ps(_mm_set1_ps(triangle.depth[0]),
+                                            _mm_add_ps(_mm_mul_ps(weight[1], _mm_set1_ps(depth_1)),
+                                                       _mm_mul_ps(weight[2], _mm_set1_ps(depth_2))));
+
+            // The last pixels of a row may not fill a whole vector, and the
+            // pixels past x1 belong to the next tile, drawn by another thread
+            float stored[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            bool const whole = x + 4 <= x1;
+            __m128 old_depth;
+            if (whole) {
+                old_depth = _mm_loadu_ps(depth_row + x);
+            } else {
+                std::copy(depth_row + x, depth_row + x + count, stored);
+                old_depth = _mm_loadu_ps(stored);
+            }
+            __m128 const pass = _mm_and_ps(covered, _mm_cmplt_ps(depth, old_depth));
+            int const mask = _mm_movemask_ps(pass);
+            if (mask == 0) {
+                continue;
+            }
+            __m128 const new_depth = _mm_or_ps(_mm_and_ps(pass, depth), _mm_andnot_ps(pass, old_depth));
+            if (whole) {
+                _mm_storeu_ps(depth_row + x, new_depth);
+            } else {
+                _mm_storeu_ps(stored, new_depth);
+                std::copy(stored, stored + count, depth_row + x);
+            }
+
+            float lane_weights[3][4];
+            for (int k = 0; k < 3; k++) {
+                _mm_storeu_ps(lane_weights[k], weight[k]);
+            }
+            for (int lane = 0; lane < count; lane++) {
+                if (mask & (1 << lane)) {
+                    float const weights[3] = {lane_weights[0][lane], lane_weights[1][lane], lane_weights[2][lane]};
+                    shade_pixel(triangle, weights, inv_area, color_row + (x + lane) * 3);
+                }
+            }
+        }
+#else
+        for (int x = x0; x < x1; x++) {
+            float const offset = float(x - x0);
+            float weights[3];
+            bool covered = true;
+            for (int k = 0; k < 3; k++) {
+                weights[k] = row[k] + edge_a[k] * offset;
+                covered = covered && (top_left[k] ? weights[k] >= 0.0f : weights[k] > 0.0f);
+            }
+            float const depth = triangle.depth[0] + weights[1] * depth_1 + weights[2] * depth_2;
+            if (!covered || !(depth < depth_row[x])) {
+                continue;
+            }
+            depth_row[x] = depth;
+            shade_pixel(triangle, weights, inv_area, color_row + x * 3);
+        }
+#endif
+    }
+}
+
+/**
+ * @brief Writes the perspective correct color of one pixel
+ */
+static void shade_pixel(RasterTriangle const &triangle, float const *weights, float inv_area, uint8_t *color) {
+    float const l0 = weights[0] * inv_area, l1 = weights[1] * inv_area, l2 = weights[2] * inv_area;
+    float const inv_w = l0 * triangle.inv_w[0] + l1 * triangle.inv_w[1] + l2 * triangle.inv_w[2];
+    glm::vec3 const value = (l0 * triangle.color[0] + l1 * triangle.color[1] + l2 * triangle.color[2]) / inv_w;
+    for (int k = 0; k < 3; k++) {
+        color[k] = static_cast<uint8_t>(glm::clamp(value[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef SOFTWARE_RASTER_H_
+#define SOFTWARE_RASTER_H_
+
+#include "../includes/common.h"
+#include "../loader/mesh.hpp"
+#include "../loader/meshlet.hpp"
+
+// Square screen tiles rasterized independently, a few KB of depth each
+constexpr int RASTER_TILE_SIZE = 64;
+
+/**
+ * @brief CPU color and depth buffers
+ *
+ * Rows run bottom to top like the default GL framebuffer, so color has the
+ * same layout as glReadPixels with GL_RGB and a pack alignment of 1.
+ */
+struct RasterTarget {
+    int width = 0;
+    int height = 0;
+    // 8 bit RGB per pixel
+    std::vector<uint8_t> color;
+    // Window depth from 0 to 1, cleared to 1
+    std::vector<float> depth;
+};
+
+/**
+ * @brief Allocates the buffers of a target
+ *
+ * @param target Target to resize, contents are undefined until cleared
+ * @param width Width in pixels
+ * @param height Height in pixels
+ */
+void resize_raster_target(RasterTarget &target, int width, int height);
+
+/**
+ * @brief Fills the color buffer and resets the depth buffer, like glClear
+ *
+ * @param target Target to clear
+ * @param color Clear color, 0 to 1 per channel
+ */
+void clear_raster_target(RasterTarget &target, glm::vec3 const &color);
+
+/**
+ * @brief Draws every instance of a mesh as GL_TRIANGLES without a GPU
+ *
+ * Mirrors the GL path: vertices go through the MVP and instance transform
+ * like vshader.glsl, colors follow fshader.glsl, the depth test is GL_LESS
+ * and nothing is face culled. Triangles are clipped to the near plane and
+ * binned into RASTER_TILE_SIZE tiles, which threads rasterize in parallel
+ * with a 4 wide depth test.
+ *
+ * @param target Target to draw into
+ * @param mesh Mesh with float or half positions
+ * @param mvp Projection and view, as from compute_mvp
+ * @param transforms One model matrix per instance
+ * @param color_mode ColorMode, as the colorMode uniform
+ * @param lod 0 for the full mesh, otherwise 1 + index into mesh.lods
+ * @param thread_count Number of threads, 0 for one per core
+ */
+void draw_raster_mesh(RasterTarget &target, Mesh const &mesh, glm::mat4 const &mvp,
+                      std::vector<glm::mat4> const &transforms, int color_mode, size_t lod = 0,
+                      unsigned thread_count = 0);
+
+/**
+ * @brief Draws ranges of the full mesh for one instance, like draw_gpu_mesh_ranges
+ *
+ * Faces keep the color they have in draw_raster_mesh at lod 0.
+ *
+ * @param target Target to draw into
+ * @param mesh Mesh with float or half positions
+ * @param mvp Projection and view, as from compute_mvp
+ * @param transform Model matrix of the instance
+ * @param color_mode ColorMode, as the colorMode uniform
+ * @param ranges Ranges of mesh.indices, e.g. from cull_meshlets
+ * @param thread_count Number of threads, 0 for one per core
+ */
+void draw_raster_mesh_ranges(RasterTarget &target, Mesh const &mesh, glm::mat4 const &mvp,
+                             glm::mat4 const &transform, int color_mode, std::vector<MeshletRange> const &ranges,
+                             unsigned thread_count = 0);
+
+#endif  // SOFTWARE_RASTER_H_
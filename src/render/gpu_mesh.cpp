@@ -0,0 +1,158 @@
+#include "gpu_mesh.hpp"
+
+#include "../loader/mesh_simplify.hpp"
+
+static void upload_buffer(GLenum target, GLuint buffer, size_t &capacity, void const *data, size_t size);
+
+void create_gpu_mesh(GpuMesh &gpu_mesh) {
+    gpu_mesh = GpuMesh();
+    glGenVertexArrays(1, &gpu_mesh.vertex_array);
+    glGenBuffers(1, &gpu_mesh.vertex_buffer);
+    glGenBuffers(1, &gpu_mesh.index_buffer);
+    glGenBuffers(1, &gpu_mesh.instance_buffer);
+
+    // The index buffer binding is part of the VAO state
+    glBindVertexArray(gpu_mesh.vertex_array);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu_mesh.index_buffer);
+
+    // Transforms advance once per instance, a mat4 takes four locations
+    glBindBuffer(GL_ARRAY_BUFFER, gpu_mesh.instance_buffer);
+    for (GLuint column = 0; column < 4; column++) {
+        GLuint const location = ATTRIBUTE_INSTANCE_TRANSFORM + column;
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              reinterpret_cast<void const *>(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+    glBindVertexArray(0);
+
+    set_gpu_mesh_instances(gpu_mesh, std::vector<glm::mat4>(1, glm::mat4(1.0f)));
+}
+
+void destroy_gpu_mesh(GpuMesh &gpu_mesh) {
+    glDeleteBuffers(1, &gpu_mesh.instance_buffer);
+    glDeleteBuffers(1, &gpu_mesh.index_buffer);
+    glDeleteBuffers(1, &gpu_mesh.vertex_buffer);
+    glDeleteVertexArrays(1, &gpu_mesh.vertex_array);
+    gpu_mesh = GpuMesh();
+}
+
+void sync_gpu_mesh(GpuMesh &gpu_mesh, Mesh const &mesh) {
+    if (!gpu_mesh.dirty) {
+        return;
+    }
+    gpu_mesh.dirty = false;
+
+    glBindVertexArray(gpu_mesh.vertex_array);
+
+    // Raw halves when the mesh was loaded without decoding
+    GLenum const position_type = mesh.positions.empty() ? GL_HALF_FLOAT : GL_FLOAT;
+    gpu_mesh.format = make_vertex_format(position_type);
+
+    // Position-only vertices are already laid out like the mesh
+    if (position_type == GL_FLOAT) {
+        upload_buffer(GL_ARRAY_BUFFER, gpu_mesh.vertex_buffer, gpu_mesh.vertex_capacity,
+                      mesh.positions.data(), mesh.positions.size() * sizeof(glm::vec3));
+    } else {
+        upload_buffer(GL_ARRAY_BUFFER, gpu_mesh.vertex_buffer, gpu_mesh.vertex_capacity,
+                      mesh.half_positions.data(), mesh.half_positions.size() * sizeof(glm::u16vec3));
+    }
+    configure_vertex_format(gpu_mesh.format);
+
+    gpu_mesh.index_type = mesh_index_type(mesh);
+    gpu_mesh.lods.clear();
+    std::vector<uint8_t> index_data;
+    for (size_t lod = 0; lod <= mesh.lods.size(); lod++) {
+        auto const &indices = lod == 0 ? mesh.indices : mesh.lods[lod - 1].indices;
+        GpuMeshLod range;
+        range.index_offset = index_data.size();
+        range.index_count = static_cast<GLsizei>(indices.size());
+        range.first_face = mesh_lod_first_face(mesh, lod);
+        gpu_mesh.lods.push_back(range);
+        pack_indices(indices, gpu_mesh.index_type, index_data);
+    }
+    gpu_mesh.edges.index_offset = index_data.size();
+    gpu_mesh.edges.index_count = static_cast<GLsizei>(mesh.edges.size());
+    pack_indices(mesh.edges, gpu_mesh.index_type, index_data);
+    upload_buffer(GL_ELEMENT_ARRAY_BUFFER, gpu_mesh.index_buffer, gpu_mesh.index_capacity,
+                  index_data.data(), index_data.size());
+
+    glBindVertexArray(0);
+}
+
+void set_gpu_mesh_instances(GpuMesh &gpu_mesh, std::vector<glm::mat4> const &transforms) {
+    upload_buffer(GL_ARRAY_BUFFER, gpu_mesh.instance_buffer, gpu_mesh.instance_capacity,
+                  transforms.data(), transforms.size() * sizeof(glm::mat4));
+    gpu_mesh.instance_count = static_cast<GLsizei>(transforms.size());
+}
+
+void set_gpu_scene(std::vector<GpuMesh> &gpu_meshes, Scene const &scene) {
+    size_t const old_count = gpu_meshes.size();
+    for (size_t i = scene.meshes.size(); i < old_count; i++) {
+        destroy_gpu_mesh(gpu_meshes[i]);
+    }
+    gpu_meshes.resize(scene.meshes.size());
+    std::vector<glm::mat4> transforms;
+    for (uint32_t i = 0; i < gpu_meshes.size(); i++) {
+        if (i >= old_count) {
+            create_gpu_mesh(gpu_meshes[i]);
+        }
+        gpu_meshes[i].dirty = true;
+        scene_mesh_transforms(scene, i, transforms);
+        set_gpu_mesh_instances(gpu_meshes[i], transforms);
+    }
+}
+
+void draw_gpu_mesh(GpuMesh const &gpu_mesh, GLenum mode, GLint first_face_location, size_t lod) {
+    if (lod >= gpu_mesh.lods.size() || gpu_mesh.instance_count == 0) {
+        return;
+    }
+    GpuMeshLod const &range = gpu_mesh.lods[lod];
+    glUniform1ui(first_face_location, range.first_face);
+    glBindVertexArray(gpu_mesh.vertex_array);
+    glDrawElementsInstanced(mode, range.index_count, gpu_mesh.index_type,
+                            reinterpret_cast<void const *>(range.index_offset), gpu_mesh.instance_count);
+    glBindVertexArray(0);
+}
+
+void draw_gpu_mesh_edges(GpuMesh const &gpu_mesh) {
+    if (gpu_mesh.edges.index_count == 0 || gpu_mesh.instance_count == 0) {
+        return;
+    }
+    glBindVertexArray(gpu_mesh.vertex_array);
+    glDrawElementsInstanced(GL_LINES, gpu_mesh.edges.index_count, gpu_mesh.index_type,
+                            reinterpret_cast<void const *>(gpu_mesh.edges.index_offset), gpu_mesh.instance_count);
+    glBindVertexArray(0);
+}
+
+void draw_gpu_mesh_ranges(GpuMesh const &gpu_mesh, GLenum mode, GLint first_face_location,
+                          std::vector<MeshletRange> const &ranges) {
+    if (ranges.empty()) {
+        return;
+    }
+    size_t const index_size = gpu_mesh.index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+    glBindVertexArray(gpu_mesh.vertex_array);
+    // cull_meshlets merges neighbouring meshlets, so there are few ranges
+    for (auto const &range : ranges) {
+        glUniform1ui(first_face_location, range.first_index / 3);
+        glDrawElements(mode, static_cast<GLsizei>(range.index_count), gpu_mesh.index_type,
+                       reinterpret_cast<void const *>(static_cast<size_t>(range.first_index) * index_size));
+    }
+    glBindVertexArray(0);
+}
+
+/**
+ * @brief Writes data into a buffer, reallocating only when it does not fit
+ *
+ * Storage is also reallocated when the data would use less than a quarter of
+ * it, so loading a small model after a huge one gives the memory back.
+ */
+static void upload_buffer(GLenum target, GLuint buffer, size_t &capacity, void const *data, size_t size) {
+    glBindBuffer(target, buffer);
+    if (size > capacity || size < capacity / 4) {
+        glBufferData(target, size, data, GL_STATIC_DRAW);
+        capacity = size;
+    } else if (size > 0) {
+        glBufferSubData(target, 0, size, data);
+    }
+}
@@ -0,0 +1,123 @@
+#ifndef GPU_MESH_H_
+#define GPU_MESH_H_
+
+#include "../includes/common.h"
+#include "../loader/mesh.hpp"
+#include "../loader/meshlet.hpp"
+#include "../loader/scene.hpp"
+#include "vertex_format.hpp"
+
+// Range of the index buffer holding one level of detail
+struct GpuMeshLod {
+    size_t index_offset;
+    GLsizei index_count;
+    // From mesh_lod_first_face, added to gl_PrimitiveID when coloring by face
+    uint32_t first_face;
+};
+
+/**
+ * @brief GL objects holding the mesh currently on screen
+ *
+ * Vertices are positions only, described by format, and the VAO is
+ * configured when the mesh is uploaded. Buffers keep their storage
+ * between loads and are only written when the mesh is marked dirty, so
+ * drawing a frame is just a VAO bind and a draw call. Every instance of the
+ * mesh is drawn by that one call, reading its transform from instance_buffer.
+ */
+struct GpuMesh {
+    GLuint vertex_array = 0;
+    GLuint vertex_buffer = 0;
+    GLuint index_buffer = 0;
+    GLuint instance_buffer = 0;
+    // Bytes allocated in each buffer, reused while new data fits
+    size_t vertex_capacity = 0;
+    size_t index_capacity = 0;
+    size_t instance_capacity = 0;
+    GLsizei instance_count = 1;
+    VertexFormat format;
+    GLenum index_type = GL_UNSIGNED_INT;
+    // Full mesh first, then mesh.lods, all in index_buffer
+    std::vector<GpuMeshLod> lods;
+    // mesh.edges, after the last level in index_buffer
+    GpuMeshLod edges = GpuMeshLod();
+    // Set when the CPU side changed and the buffers need uploading
+    bool dirty = true;
+};
+
+/**
+ * @brief Creates the VAO and buffers, needs a current GL context
+ *
+ * @param gpu_mesh Output GL objects
+ */
+void create_gpu_mesh(GpuMesh &gpu_mesh);
+
+/**
+ * @brief Deletes the VAO and buffers
+ *
+ * @param gpu_mesh GL objects made by create_gpu_mesh
+ */
+void destroy_gpu_mesh(GpuMesh &gpu_mesh);
+
+/**
+ * @brief Uploads the mesh if the GPU copy is dirty
+ *
+ * Colors are computed by the shaders, so only positions are uploaded. The
+ * indices of every level of detail and the edges share one index buffer.
+ *
+ * @param gpu_mesh GL objects to upload into
+ * @param mesh Mesh to upload
+ */
+void sync_gpu_mesh(GpuMesh &gpu_mesh, Mesh const &mesh);
+
+/**
+ * @brief Replaces the transforms the mesh is drawn with
+ *
+ * @param gpu_mesh GL objects made by create_gpu_mesh
+ * @param transforms One model matrix per instance
+ */
+void set_gpu_mesh_instances(GpuMesh &gpu_mesh, std::vector<glm::mat4> const &transforms);
+
+/**
+ * @brief Makes one GpuMesh per scene mesh and uploads the instance transforms
+ *
+ * Existing GL objects are reused and marked dirty, extra ones are deleted,
+ * so the meshes themselves upload on their next sync_gpu_mesh.
+ *
+ * @param gpu_meshes GL objects, resized to match scene.meshes
+ * @param scene Scene about to be drawn
+ */
+void set_gpu_scene(std::vector<GpuMesh> &gpu_meshes, Scene const &scene);
+
+/**
+ * @brief Draws every instance of the whole mesh at one level of detail
+ *
+ * @param gpu_mesh GL objects to draw
+ * @param mode Primitive type passed to glDrawElementsInstanced
+ * @param first_face_location Location of the firstFace uniform of the bound program
+ * @param lod 0 for the full mesh, otherwise 1 + index into mesh.lods
+ */
+void draw_gpu_mesh(GpuMesh const &gpu_mesh, GLenum mode, GLint first_face_location, size_t lod = 0);
+
+/**
+ * @brief Draws every instance of the unique edges as GL_LINES
+ *
+ * @param gpu_mesh GL objects to draw
+ */
+void draw_gpu_mesh_edges(GpuMesh const &gpu_mesh);
+
+/**
+ * @brief Draws ranges of the full mesh, one draw call per range
+ *
+ * gl_PrimitiveID restarts with every draw, so each range sets firstFace to
+ * its own first triangle and faces keep the color of the unculled mesh.
+ * Only the first instance is drawn, culled ranges differ between instances.
+ *
+ * @param gpu_mesh GL objects to draw
+ * @param mode Primitive type
+ * @param first_face_location Location of the firstFace uniform of the bound program
+ * @param ranges Ranges of mesh.indices, e.g. from cull_meshlets
+ */
+void draw_gpu_mesh_ranges(GpuMesh const &gpu_mesh, GLenum mode, GLint first_face_location,
+                          std::vector<MeshletRange> const &ranges);
+
+#endif  // GPU_MESH_H_
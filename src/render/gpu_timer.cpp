@@ -0,0 +1,59 @@
+#include "gpu_timer.hpp"
+
+void create_gpu_timer(GpuTimer &timer, unsigned stage) {
+    glGenQueries(GPU_TIMER_LATENCY, timer.queries);
+    for (size_t i = 0; i < GPU_TIMER_LATENCY; i++) {
+        timer.pending[i] = false;
+    }
+    timer.next = 0;
+    timer.active = false;
+    timer.stage = stage;
+}
+
+void destroy_gpu_timer(GpuTimer &timer) {
+    glDeleteQueries(GPU_TIMER_LATENCY, timer.queries);
+    for (size_t i = 0; i < GPU_TIMER_LATENCY; i++) {
+        timer.queries[i] = 0;
+        timer.pending[i] = false;
+    }
+}
+
+void begin_gpu_timer(GpuTimer &timer, FrameProfiler const &profiler) {
+    // The oldest query has not been read yet, drop this frame instead of waiting
+    if (timer.active || timer.pending[timer.next]) {
+        return;
+    }
+    timer.frames[timer.next] = profiler.frame;
+    timer.start_ms[timer.next] = profile_now_ms(profiler);
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.next]);
+    timer.active = true;
+}
+
+void end_gpu_timer(GpuTimer &timer) {
+    if (!timer.active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.pending[timer.next] = true;
+    timer.next = (timer.next + 1) % GPU_TIMER_LATENCY;
+    timer.active = false;
+}
+
+void poll_gpu_timer(GpuTimer &timer, FrameProfiler &profiler) {
+    // Oldest first, queries finish in the order they were issued
+    for (size_t i = 0; i < GPU_TIMER_LATENCY; i++) {
+        size_t const slot = (timer.next + i) % GPU_TIMER_LATENCY;
+        if (!timer.pending[slot]) {
+            continue;
+        }
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(timer.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(timer.queries[slot], GL_QUERY_RESULT, &elapsed_ns);
+        add_profile_sample(profiler, timer.stage, timer.frames[slot], timer.start_ms[slot], elapsed_ns / 1.0e6);
+        timer.pending[slot] = false;
+    }
+}
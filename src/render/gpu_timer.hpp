@@ -0,0 +1,67 @@
+#ifndef GPU_TIMER_H_
+#define GPU_TIMER_H_
+
+#include "../includes/common.h"
+#include "../utils/profiler.hpp"
+
+// Frames a query may stay in flight before its result is read
+constexpr size_t GPU_TIMER_LATENCY = 4;
+
+/**
+ * @brief Ring of GL_TIME_ELAPSED queries around one stage of the frame
+ *
+ * Results are read only once available, so timing never stalls the pipeline;
+ * a frame's GPU time reaches the profiler a few frames after it was drawn.
+ */
+struct GpuTimer {
+    GLuint queries[GPU_TIMER_LATENCY] = {};
+    // Frame and CPU start of each query, pending until its result is read
+    uint64_t frames[GPU_TIMER_LATENCY] = {};
+    double start_ms[GPU_TIMER_LATENCY] = {};
+    bool pending[GPU_TIMER_LATENCY] = {};
+    size_t next = 0;
+    bool active = false;
+    unsigned stage = STAGE_GPU_DRAW;
+};
+
+/**
+ * @brief Creates the queries, needs a current GL context
+ *
+ * @param timer Output timer
+ * @param stage ProfileStage the results are added to
+ */
+void create_gpu_timer(GpuTimer &timer, unsigned stage);
+
+/**
+ * @brief Deletes the queries
+ *
+ * @param timer Timer made by create_gpu_timer
+ */
+void destroy_gpu_timer(GpuTimer &timer);
+
+/**
+ * @brief Starts timing GL commands of the current frame
+ *
+ * Skipped when every query is still in flight.
+ *
+ * @param timer Timer to start
+ * @param profiler Profiler giving the frame number and CPU time
+ */
+void begin_gpu_timer(GpuTimer &timer, FrameProfiler const &profiler);
+
+/**
+ * @brief Stops timing, the result is read by a later poll_gpu_timer
+ *
+ * @param timer Timer to stop
+ */
+void end_gpu_timer(GpuTimer &timer);
+
+/**
+ * @brief Adds finished queries to the profiler without waiting on the GPU
+ *
+ * @param timer Timer to read
+ * @param profiler Profiler to add the GPU times to
+ */
+void poll_gpu_timer(GpuTimer &timer, FrameProfiler &profiler);
+
+#endif  // GPU_TIMER_H_
@@ -0,0 +1,385 @@
+#include "thumbnail.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <zlib.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include "gpu_mesh.hpp"
+#include "../raster/software_raster.hpp"
+#include "../loader/async_loader.hpp"
+#include "../shader/shader.hpp"
+#include "../utils/utils.hpp"
+
+struct HeadlessContext {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+};
+
+// Color and depth attachments of the offscreen target
+struct ThumbnailTarget {
+    GLuint framebuffer = 0;
+    GLuint color = 0;
+    GLuint depth = 0;
+};
+
+static CameraPreset const CAMERA_PRESETS[] = {
+    {"front", 90.0f, 90.0f}, {"back", 270.0f, 90.0f},   {"left", 180.0f, 90.0f}, {"right", 0.0f, 90.0f},
+    {"top", 90.0f, 0.01f},   {"bottom", 90.0f, 179.99f}, {"iso", 45.0f, 54.74f},
+};
+
+static bool create_headless_context(HeadlessContext &context);
+static void destroy_headless_context(HeadlessContext &context);
+static bool create_thumbnail_target(ThumbnailTarget &target, int width, int height);
+static void destroy_thumbnail_target(ThumbnailTarget &target);
+static bool write_png(std::string const &path, int width, int height, std::vector<uint8_t> const &pixels);
+static void append_png_chunk(std::vector<uint8_t> &png, char const *type, uint8_t const *data, size_t size);
+static void append_u32(std::vector<uint8_t> &bytes, uint32_t value);
+
+bool find_camera_preset(std::string const &name, CameraPreset &preset) {
+    for (auto const &known : CAMERA_PRESETS) {
+        if (known.name == name) {
+            preset = known;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_thumbnail_args(int argc, char **argv, ThumbnailOptions &options, std::vector<std::string> &paths) {
+    if (argc < 1) {
+        printf("Missing the output directory\n");
+        return false;
+    }
+    options.output_dir = argv[0];
+    for (int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        bool const has_value = i + 1 < argc;
+        if (arg == "--size" && has_value) {
+            if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 ||
+                options.height <= 0) {
+                printf("Invalid size: '%s'\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--presets" && has_value) {
+            std::stringstream names(argv[++i]);
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                CameraPreset preset;
+                if (!find_camera_preset(name, preset)) {
+                    printf("Unknown camera preset: '%s'\n", name.c_str());
+                    return false;
+                }
+                options.presets.push_back(preset);
+            }
+        } else if (arg == "--list" && has_value) {
+            std::ifstream list(argv[++i]);
+            if (!list.is_open()) {
+                printf("There was an error opening file: '%s'\n", argv[i]);
+                return false;
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty()) {
+                    paths.push_back(line);
+                }
+            }
+        } else if (arg == "--cpu") {
+            options.software = true;
+        } else if (arg == "--color-by-face") {
+            options.color_mode = COLOR_BY_FACE;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            printf("Unknown option: '%s'\n", arg.c_str());
+            return false;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (options.presets.empty()) {
+        CameraPreset preset;
+        find_camera_preset("iso", preset);
+        options.presets.push_back(preset);
+    }
+    return true;
+}
+
+bool render_thumbnails(std::vector<std::string> const &paths, ThumbnailOptions const &options) {
+    if (mkdir(options.output_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        printf("Could not create directory: '%s'\n", options.output_dir.c_str());
+        return false;
+    }
+
+    // The software rasterizer needs no context, so it also runs without any GL driver
+    HeadlessContext context;
+    ThumbnailTarget target;
+    GLuint program = 0;
+    GLint matrix_id = -1;
+    GLint first_face_id = -1;
+    RasterTarget raster;
+    if (options.software) {
+        resize_raster_target(raster, options.width, options.height);
+    } else {
+        if (!create_headless_context(context)) {
+            return false;
+        }
+        if (!create_thumbnail_target(target, options.width, options.height)) {
+            destroy_headless_context(context);
+            return false;
+        }
+        program = LoadShaders("./shader/vshader.glsl", "./shader/fshader.glsl");
+        glUseProgram(program);
+        matrix_id = glGetUniformLocation(program, "MVP");
+        first_face_id = glGetUniformLocation(program, "firstFace");
+        glUniform1i(glGetUniformLocation(program, "colorMode"), options.color_mode);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glViewport(0, 0, options.width, options.height);
+        glClearColor(options.background.x, options.background.y, options.background.z, 1.0f);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    }
+
+    AsyncModelLoader loader;
+    start_async_loader(loader);
+    if (!paths.empty()) {
+        request_model_load(loader, paths[0], options.load_flags);
+    }
+
+    Scene scene;
+    std::vector<GpuMesh> gpu_meshes;
+    std::vector<glm::mat4> transforms;
+    std::vector<uint8_t> pixels(static_cast<size_t>(options.width) * options.height * 3);
+    float const aspect = static_cast<float>(options.width) / static_cast<float>(options.height);
+    size_t failed = 0, images = 0;
+    auto const start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        ModelLoadResult loaded;
+        bool const finished = wait_model_load(loader, loaded);
+        // The next file parses while this one renders
+        if (i + 1 < paths.size()) {
+            request_model_load(loader, paths[i + 1], options.load_flags);
+        }
+        if (!finished || (loaded.scene.instances.empty() && loaded.mesh.indices.empty())) {
+            printf("Could not load model: '%s'\n", paths[i].c_str());
+            failed++;
+            continue;
+        }
+        if (loaded.scene.instances.empty()) {
+            make_mesh_scene(loaded.path, loaded.mesh, loaded.scene);
+        }
+        scene = std::move(loaded.scene);
+        if (!options.software) {
+            set_gpu_scene(gpu_meshes, scene);
+        }
+
+        std::string name = get_filename(paths[i]);
+        name = name.substr(0, name.find_last_of('.'));
+        // Far enough for the bounding sphere to fit the narrower side of the image
+        float const radius = std::max(scene.bounding_radius, 1e-6f);
+        float const half_fov = std::atan(std::min(1.0f, aspect) * std::tan(glm::radians(options.fov) * 0.5f));
+        float const distance = radius / std::sin(half_fov);
+        for (auto const &preset : options.presets) {
+            glm::vec3 camera_position;
+            calculate_camera_position(camera_position, distance, preset.yaw, preset.pitch);
+            glm::mat4 const mvp = compute_mvp(options.fov, camera_position + scene.model_center, scene.model_center,
+                                              distance - radius * 1.01f, distance + radius, aspect);
+
+            if (options.software) {
+                clear_raster_target(raster, options.background);
+                for (uint32_t m = 0; m < scene.meshes.size(); m++) {
+                    scene_mesh_transforms(scene, m, transforms);
+                    draw_raster_mesh(raster, scene.meshes[m], mvp, transforms, options.color_mode);
+                }
+            } else {
+                glUniformMatrix4fv(matrix_id, 1, GL_FALSE, &mvp[0][0]);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                for (size_t m = 0; m < gpu_meshes.size(); m++) {
+                    sync_gpu_mesh(gpu_meshes[m], scene.meshes[m]);
+                    draw_gpu_mesh(gpu_meshes[m], GL_TRIANGLES, first_face_id);
+                }
+                glReadPixels(0, 0, options.width, options.height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+            }
+
+            std::string const image_path = options.output_dir + "/" + name + "_" + preset.name + ".png";
+            if (!write_png(image_path, options.width, options.height, options.software ? raster.color : pixels)) {
+                failed++;
+                continue;
+            }
+            images++;
+        }
+    }
+
+    double const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("Thumbnails: %zu files, %zu images, %zu failed in %.2f s (%.1f files/s)\n", paths.size(), images,
+           failed, seconds, seconds > 0.0 ? paths.size() / seconds : 0.0);
+
+    stop_async_loader(loader);
+    if (!options.software) {
+        for (auto &gpu_mesh : gpu_meshes) {
+            destroy_gpu_mesh(gpu_mesh);
+        }
+        glDeleteProgram(program);
+        destroy_thumbnail_target(target);
+        destroy_headless_context(context);
+    }
+    return failed == 0;
+}
+
+/**
+ * @brief Makes a GL 3.3 core context current without any window or surface
+ *
+ * Prefers Mesa's surfaceless platform, which needs no display server, and
+ * falls back to the default EGL display.
+ */
+static bool create_headless_context(HeadlessContext &context) {
+    auto const get_platform_display =
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (get_platform_display != nullptr) {
+        context.display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (context.display == EGL_NO_DISPLAY) {
+        context.display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major = 0, minor = 0;
+    if (context.display == EGL_NO_DISPLAY || !eglInitialize(context.display, &major, &minor)) {
+        printf("Could not initialize EGL\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        printf("EGL has no desktop OpenGL\n");
+        destroy_headless_context(context);
+        return false;
+    }
+
+    // The default surface type is a window, which surfaceless displays never offer
+    EGLint const config_attributes[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config;
+    EGLint config_count = 0;
+    if (!eglChooseConfig(context.display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        printf("No EGL config for OpenGL\n");
+        destroy_headless_context(context);
+        return false;
+    }
+    EGLint const context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+                                         EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                         EGL_NONE};
+    context.context = eglCreateContext(context.display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context.context == EGL_NO_CONTEXT ||
+        !eglMakeCurrent(context.display, EGL_NO_SURFACE, EGL_NO_SURFACE, context.context)) {
+        printf("Could not create a surfaceless OpenGL 3.3 context\n");
+        destroy_headless_context(context);
+        return false;
+    }
+
+    // glewInit also looks for a GLX display, which a headless box lacks
+    glewExperimental = GL_TRUE;
+    if (glewContextInit() != GLEW_OK) {
+        printf("Failed to initialize GLEW\n");
+        destroy_headless_context(context);
+        return false;
+    }
+    printf("Headless renderer: %s\n", reinterpret_cast<char const *>(glGetString(GL_RENDERER)));
+    return true;
+}
+
+static void destroy_headless_context(HeadlessContext &context) {
+    if (context.display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(context.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context.context != EGL_NO_CONTEXT) {
+        eglDestroyContext(context.display, context.context);
+    }
+    eglTerminate(context.display);
+    context = HeadlessContext();
+}
+
+static bool create_thumbnail_target(ThumbnailTarget &target, int width, int height) {
+    glGenRenderbuffers(1, &target.color);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &target.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, target.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glGenFramebuffers(1, &target.framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        printf("Offscreen framebuffer is incomplete\n");
+        destroy_thumbnail_target(target);
+        return false;
+    }
+    return true;
+}
+
+static void destroy_thumbnail_target(ThumbnailTarget &target) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &target.framebuffer);
+    glDeleteRenderbuffers(1, &target.depth);
+    glDeleteRenderbuffers(1, &target.color);
+    target = ThumbnailTarget();
+}
+
+/**
+ * @brief Writes 8 bit RGB pixels, bottom row first as GL reads them, to a PNG
+ */
+static bool write_png(std::string const &path, int width, int height, std::vector<uint8_t> const &pixels) {
+    // Every row starts with its filter type, 0 for none
+    size_t const row_size = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> rows;
+    rows.reserve((row_size + 1) * height);
+    for (int y = height - 1; y >= 0; y--) {
+        rows.push_back(0);
+        rows.insert(rows.end(), pixels.begin() + y * row_size, pixels.begin() + (y + 1) * row_size);
+    }
+    uLongf compressed_size = compressBound(rows.size());
+    std::vector<uint8_t> compressed(compressed_size);
+    if (compress2(compressed.data(), &compressed_size, rows.data(), rows.size(), Z_DEFAULT_COMPRESSION) != Z_OK) {
+        printf("Could not compress image: '%s'\n", path.c_str());
+        return false;
+    }
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+    std::vector<uint8_t> header;
+    append_u32(header, static_cast<uint32_t>(width));
+    append_u32(header, static_cast<uint32_t>(height));
+    // 8 bits per channel, RGB, deflate, adaptive filters, no interlace
+    uint8_t const format[] = {8, 2, 0, 0, 0};
+    header.insert(header.end(), format, format + sizeof(format));
+    append_png_chunk(png, "IHDR", header.data(), header.size());
+    append_png_chunk(png, "IDAT", compressed.data(), compressed_size);
+    append_png_chunk(png, "IEND", nullptr, 0);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.write(reinterpret_cast<char const *>(png.data()), png.size())) {
+        printf("There was an error writing file: '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static void append_png_chunk(std::vector<uint8_t> &png, char const *type, uint8_t const *data, size_t size) {
+    append_u32(png, static_cast<uint32_t>(size));
+    size_t const type_start = png.size();
+    png.insert(png.end(), type, type + 4);
+    if (size > 0) {
+        png.insert(png.end(), data, data + size);
+    }
+    // The checksum covers the type and the data
+    append_u32(png, static_cast<uint32_t>(crc32(0, png.data() + type_start, static_cast<uInt>(size + 4))));
+}
+
+static void append_u32(std::vector<uint8_t> &bytes, uint32_t value) {
+    uint8_t const big_endian[] = {uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value)};
+    bytes.insert(bytes.end(), big_endian, big_endian + 4);
+}
@@ -0,0 +1,75 @@
+#ifndef THUMBNAIL_H_
+#define THUMBNAIL_H_
+
+#include "../includes/common.h"
+
+/**
+ * @brief Named orbit angles, same convention as the viewer camera
+ */
+struct CameraPreset {
+    std::string name;
+    float yaw;
+    float pitch;
+};
+
+/**
+ * @brief What render_thumbnails draws and where it writes
+ */
+struct ThumbnailOptions {
+    std::string output_dir = ".";
+    int width = 256;
+    int height = 256;
+    float fov = 45.0f;
+    // One image per file and preset, named <file>_<preset>.png
+    std::vector<CameraPreset> presets;
+    // Bitmask of LoadFlags
+    unsigned load_flags = 0;
+    glm::vec3 background = glm::vec3(0.29f);
+    // ColorMode of the shaders
+    int color_mode = COLOR_BY_VERTEX;
+    // Draw with the CPU rasterizer instead of an EGL context
+    bool software = false;
+};
+
+/**
+ * @brief Looks up one of the built-in camera presets
+ *
+ * Known names are front, back, left, right, top, bottom and iso.
+ *
+ * @param name Preset name
+ * @param preset Output angles
+ * @return Returns false for an unknown name
+ */
+bool find_camera_preset(std::string const &name, CameraPreset &preset);
+
+/**
+ * @brief Reads the arguments following --thumbnails
+ *
+ * Usage: <output dir> [--size WxH] [--presets a,b,...] [--list file] [--cpu]
+ *        [--color-by-face] [files...]
+ * A list file holds one model path per line.
+ *
+ * @param argc Number of arguments
+ * @param argv Arguments after --thumbnails
+ * @param options Output options
+ * @param paths Output model paths
+ * @return Returns false and prints the problem if the arguments are invalid
+ */
+bool parse_thumbnail_args(int argc, char **argv, ThumbnailOptions &options, std::vector<std::string> &paths);
+
+/**
+ * @brief Renders every file to PNG images without a window
+ *
+ * Uses a surfaceless EGL context, so it runs on a headless box with Mesa
+ * llvmpipe, or the software rasterizer when options.software is set. The
+ * context, shader program, framebuffer and GPU buffers are reused across
+ * files, and the next file loads on a worker thread while the current one
+ * renders.
+ *
+ * @param paths Model (.obj, .model) or .scene files
+ * @param options Image size, presets and output directory
+ * @return Returns false if the context could not be made or any file failed
+ */
+bool render_thumbnails(std::vector<std::string> const &paths, ThumbnailOptions const &options);
+
+#endif  // THUMBNAIL_H_
@@ -0,0 +1,47 @@
+#include "vertex_format.hpp"
+
+static void add_attribute(VertexFormat &format, GLuint location, GLint size, GLenum type, GLboolean normalized,
+                          GLuint bytes);
+
+VertexFormat make_vertex_format(GLenum position_type) {
+    VertexFormat format;
+    if (position_type == GL_HALF_FLOAT) {
+        add_attribute(format, ATTRIBUTE_POSITION, 3, GL_HALF_FLOAT, GL_FALSE, sizeof(glm::u16vec3));
+    } else {
+        add_attribute(format, ATTRIBUTE_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3));
+    }
+    return format;
+}
+
+VertexAttribute const *find_vertex_attribute(VertexFormat const &format, GLuint location) {
+    for (size_t i = 0; i < format.attribute_count; i++) {
+        if (format.attributes[i].location == location) {
+            return &format.attributes[i];
+        }
+    }
+    return nullptr;
+}
+
+void configure_vertex_format(VertexFormat const &format) {
+    for (GLuint location = 0; location < MAX_VERTEX_ATTRIBUTES; location++) {
+        VertexAttribute const *attribute = find_vertex_attribute(format, location);
+        if (attribute == nullptr) {
+            glDisableVertexAttribArray(location);
+            continue;
+        }
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, attribute->size, attribute->type, attribute->normalized, format.stride,
+                              reinterpret_cast<void const *>(static_cast<uintptr_t>(attribute->offset)));
+    }
+}
+
+static void add_attribute(VertexFormat &format, GLuint location, GLint size, GLenum type, GLboolean normalized,
+                          GLuint bytes) {
+    VertexAttribute &attribute = format.attributes[format.attribute_count++];
+    attribute.location = location;
+    attribute.size = size;
+    attribute.type = type;
+    attribute.normalized = normalized;
+    attribute.offset = static_cast<GLuint>(format.stride);
+    format.stride += static_cast<GLsizei>(bytes);
+}
@@ -0,0 +1,59 @@
+#ifndef VERTEX_FORMAT_H_
+#define VERTEX_FORMAT_H_
+
+#include "../includes/common.h"
+
+// Attribute locations shared with the vertex shader
+enum VertexAttributeLocation : GLuint {
+    ATTRIBUTE_POSITION = 0,
+    // Per-instance mat4, one column per location from 3 to 6
+    ATTRIBUTE_INSTANCE_TRANSFORM = 3,
+};
+
+// Colors are computed by the shaders, so positions are the only vertex attribute
+constexpr size_t MAX_VERTEX_ATTRIBUTES = 1;
+
+struct VertexAttribute {
+    GLuint location;
+    GLint size;
+    GLenum type;
+    GLboolean normalized;
+    GLuint offset;
+};
+
+/**
+ * @brief Layout of one vertex in the vertex buffer
+ *
+ * Positions keep the type they were loaded with (GL_FLOAT or GL_HALF_FLOAT),
+ * so a vertex takes 12 or 6 bytes.
+ */
+struct VertexFormat {
+    VertexAttribute attributes[MAX_VERTEX_ATTRIBUTES];
+    size_t attribute_count = 0;
+    GLsizei stride = 0;
+};
+
+/**
+ * @brief Describes the vertex for a position type
+ *
+ * @param position_type GL_FLOAT or GL_HALF_FLOAT
+ */
+VertexFormat make_vertex_format(GLenum position_type);
+
+/**
+ * @brief Finds an attribute by shader location
+ *
+ * @param format Format to search
+ * @param location One of VertexAttributeLocation
+ * @return Returns nullptr if the format does not have it
+ */
+VertexAttribute const *find_vertex_attribute(VertexFormat const &format, GLuint location);
+
+/**
+ * @brief Sets the attribute pointers of the bound VAO for the bound vertex buffer
+ *
+ * @param format Format of the vertices in GL_ARRAY_BUFFER
+ */
+void configure_vertex_format(VertexFormat const &format);
+
+#endif  // VERTEX_FORMAT_H_
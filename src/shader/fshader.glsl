@@ -1,8 +1,35 @@
 #version 330 core
 
+// Keep in sync with ColorMode in common.h
+#define COLOR_BY_VERTEX 0
+#define COLOR_BY_FACE 1
+
 in vec3 fragmentColor;
 out vec3 color;
 
+uniform int colorMode;
+// Face id of the first triangle of the draw, see mesh_lod_first_face
+uniform uint firstFace;
+
+// Same hash as the vertex shader
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+vec3 hash_color(uint id) {
+    uint h = hash(id);
+    return vec3(uvec3(h, h >> 8, h >> 16) & 0xFFU) / 255.0;
+}
+
 void main(){
-  color = fragmentColor;
+  if (colorMode == COLOR_BY_FACE) {
+    color = hash_color(firstFace + uint(gl_PrimitiveID));
+  } else {
+    color = fragmentColor;
+  }
 }
@@ -1,13 +1,30 @@
 #version 330 core
 
 layout(location = 0) in vec3 vertexPosition_modelspace;
-layout(location = 1) in vec3 vertexColor;
+layout(location = 3) in mat4 instanceTransform;
 
 out vec3 fragmentColor;
 
 uniform mat4 MVP;
 
+// Integer hash (lowbias32), spreads consecutive ids over the whole range
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+vec3 hash_color(uint id) {
+    uint h = hash(id);
+    return vec3(uvec3(h, h >> 8, h >> 16) & 0xFFU) / 255.0;
+}
+
 void main() {
-    gl_Position = MVP * vec4(vertexPosition_modelspace, 1);
-    fragmentColor = vertexColor;
+    gl_Position = MVP * instanceTransform * vec4(vertexPosition_modelspace, 1);
+    // With glDrawElements this is the vertex index, so shared corners match,
+    // and each instance of a mesh gets its own palette
+    fragmentColor = hash_color(uint(gl_VertexID) + uint(gl_InstanceID) * 0x9e3779b9U);
 }
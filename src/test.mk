@@ -4,12 +4,12 @@ GCOV_FLAGS  	:= 		--coverage -fprofile-instr-generate -fcoverage-mapping
 ASAN			:=		-g -fsanitize=address
 CFLAGS			:=		-std=c++11 -Wall -Werror -Wextra  #$(ASAN)
 CFLAGS 			+= 		$(shell pkg-config --cflags gtest glm glew glfw3)
-LDFLAGS 		:= 		$(shell pkg-config --libs gtest glm glew glfw3) 
+LDFLAGS 		:= 		$(shell pkg-config --libs gtest glm glew glfw3) -pthread
 
 TARGET			:= 		test
 TARGET_LIB 		:= 		s21_3d_model_viewer.a
 
-MODULES			:= 		$(shell find . -type d | grep -E "utils|loader")
+MODULES			:= 		$(shell find . -type d | grep -E "utils|loader|raster")
 TEST_MODULES	:= 		$(shell find . -type d | grep -E "tests")
 
 SRC				:= 		$(notdir $(shell find $(MODULES) -maxdepth 1 -name "*.cpp"))
@@ -64,6 +64,7 @@ clean			:
 					rm -rf $(TARGET)
 					rm -rf coverage*
 					rm -rf default.*
+					rm -rf mesh_cache
 
 re: clean $(TARGET)
 
@@ -1,5 +1,22 @@
 #include "gtest/gtest.h"
 #include "../loader/loader.hpp"
+#include "../loader/mesh_cache.hpp"
+#include "../loader/half_float.hpp"
+#include "../loader/async_loader.hpp"
+#include "../loader/mesh_optimize.hpp"
+#include "../loader/mesh_simplify.hpp"
+#include "../loader/meshlet.hpp"
+#include "../loader/mesh_edges.hpp"
+#include "../loader/scene.hpp"
+#include "../loader/mesh_generator.hpp"
+#include "../loader/mesh_bounds.hpp"
+#include "../loader/pure_model.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 
 TEST(test_loader, simple_loader) {
     std::vector<glm::vec3> vertices;
@@ -80,3 +97,743 @@ TEST(test_loader, simple_loader3) {
         ASSERT_NEAR(vals[i][2], vertices[i][2], 1e-02);
     }
 }
+
+TEST(test_loader, parallel_loader_matches_serial) {
+    char const *models[] = {"./models/box.obj", "./models/pyramid.obj",
+                            "./models/octahedron.obj", "./models/tetrahedron.obj"};
+
+    for (auto model : models) {
+        std::vector<glm::vec3> serial, parallel;
+        size_t serial_fc = 0, serial_vc = 0;
+        load_obj(model, serial, serial_fc, serial_vc);
+
+        for (unsigned threads = 1; threads <= 8; threads++) {
+            parallel.clear();
+            size_t fc = 0, vc = 0;
+            load_obj_parallel(model, parallel, fc, vc, threads);
+
+            ASSERT_EQ(serial_fc, fc);
+            ASSERT_EQ(serial_vc, vc);
+            ASSERT_EQ(serial.size(), parallel.size());
+            for (size_t i = 0; i < serial.size(); i++) {
+                ASSERT_EQ(serial[i], parallel[i]);
+            }
+        }
+    }
+}
+
+TEST(test_loader, indexed_mesh_matches_triangle_list) {
+    char const *models[] = {"./models/box.obj", "./models/pyramid.obj",
+                            "./models/octahedron.obj", "./models/tetrahedron.obj"};
+
+    for (auto model : models) {
+        std::vector<glm::vec3> vertices;
+        size_t fc = 0, vc = 0;
+        load_obj(model, vertices, fc, vc);
+
+        Mesh mesh;
+        load_model(model, mesh);
+        ASSERT_EQ(fc, mesh.faces_count);
+        ASSERT_EQ(vc, mesh.vertices_count);
+        ASSERT_EQ(vertices.size(), mesh.indices.size());
+        for (size_t i = 0; i < vertices.size(); i++) {
+            ASSERT_EQ(vertices[i], mesh.positions[mesh.indices[i]]);
+        }
+
+        std::vector<glm::vec3> expanded;
+        expand_mesh(mesh, expanded);
+        ASSERT_EQ(vertices, expanded);
+    }
+}
+
+TEST(test_loader, indexed_mesh_packs_short_indices) {
+    Mesh mesh;
+    load_model("./models/box.obj", mesh);
+    ASSERT_EQ(static_cast<GLenum>(GL_UNSIGNED_SHORT), mesh_index_type(mesh));
+
+    std::vector<uint8_t> index_data;
+    pack_mesh_indices(mesh, index_data);
+    ASSERT_EQ(mesh.indices.size() * sizeof(uint16_t), index_data.size());
+    auto short_indices = reinterpret_cast<uint16_t const *>(index_data.data());
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        ASSERT_EQ(mesh.indices[i], short_indices[i]);
+    }
+}
+
+TEST(test_loader, mesh_cache_roundtrip) {
+    Mesh loaded;
+    load_model("./models/octahedron.obj", loaded);
+
+    Mesh cached;
+    ASSERT_TRUE(load_mesh_cache("./models/octahedron.obj", cached));
+    ASSERT_EQ(loaded.positions, cached.positions);
+    ASSERT_EQ(loaded.indices, cached.indices);
+    ASSERT_EQ(loaded.faces_count, cached.faces_count);
+    ASSERT_EQ(loaded.vertices_count, cached.vertices_count);
+    ASSERT_EQ(loaded.model_size, cached.model_size);
+    ASSERT_EQ(loaded.model_center, cached.model_center);
+}
+
+TEST(test_loader, mesh_cache_detects_changes) {
+    char const *path = "./mesh_cache_test.obj";
+    FILE *file = fopen(path, "w");
+    ASSERT_NE(nullptr, file);
+    fputs("v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\nf 1 2 3\n", file);
+    fclose(file);
+
+    Mesh mesh;
+    load_model(path, mesh);
+    ASSERT_TRUE(load_mesh_cache(path, mesh));
+
+    file = fopen(path, "a");
+    ASSERT_NE(nullptr, file);
+    fputs("f 1 2 4\n", file);
+    fclose(file);
+
+    ASSERT_FALSE(load_mesh_cache(path, mesh));
+    load_model(path, mesh);
+    ASSERT_EQ(2u, mesh.faces_count);
+    remove(path);
+}
+
+TEST(test_loader, mesh_cache_rejects_bad_indices) {
+    char const *path = "./mesh_cache_bad_indices.obj";
+    FILE *file = fopen(path, "w");
+    ASSERT_NE(nullptr, file);
+    fputs("v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 1\nf 1 2 3\nf 1 3 4\n", file);
+    fclose(file);
+
+    Mesh mesh;
+    load_model(path, mesh);
+    mesh.indices[4] = static_cast<uint32_t>(mesh.positions.size());
+    ASSERT_TRUE(save_mesh_cache(path, mesh));
+
+    Mesh cached;
+    cached.faces_count = 7;
+    ASSERT_FALSE(load_mesh_cache(path, cached));
+    ASSERT_EQ(7u, cached.faces_count);
+    ASSERT_TRUE(cached.indices.empty());
+    remove(path);
+}
+
+TEST(test_loader, unknown_type_loads_empty) {
+    Mesh mesh;
+    mesh.faces_count = 3;
+    load_model("./models/box.stl", mesh);
+    ASSERT_TRUE(mesh.indices.empty());
+    ASSERT_EQ(0u, mesh.faces_count);
+}
+
+TEST(test_loader, half_float_values) {
+    EXPECT_EQ(0.0f, convert_float16_to_float32(uint16_t(0x0000)));
+    EXPECT_TRUE(std::signbit(convert_float16_to_float32(uint16_t(0x8000))));
+    EXPECT_EQ(1.0f, convert_float16_to_float32(uint16_t(0x3C00)));
+    EXPECT_EQ(-2.0f, convert_float16_to_float32(uint16_t(0xC000)));
+    EXPECT_EQ(65504.0f, convert_float16_to_float32(uint16_t(0x7BFF)));
+    EXPECT_EQ(std::ldexp(1.0f, -24), convert_float16_to_float32(uint16_t(0x0001)));
+    EXPECT_EQ(std::ldexp(1023.0f, -24), convert_float16_to_float32(uint16_t(0x03FF)));
+    EXPECT_TRUE(std::isinf(convert_float16_to_float32(uint16_t(0x7C00))));
+    EXPECT_TRUE(std::isnan(convert_float16_to_float32(uint16_t(0x7C01))));
+}
+
+TEST(test_loader, half_float_batch_matches_scalar) {
+    // Odd count so the vector kernels leave a scalar tail
+    size_t const count = 0x10000 + 3;
+    std::vector<uint16_t> halves(count);
+    for (size_t i = 0; i < count; i++) {
+        halves[i] = static_cast<uint16_t>(i);
+    }
+
+    std::vector<float> floats(count);
+    convert_float16_to_float32(halves.data(), floats.data(), count);
+    for (size_t i = 0; i < count; i++) {
+        float const expected = convert_float16_to_float32(halves[i]);
+        ASSERT_EQ(0, memcmp(&expected, &floats[i], sizeof(float))) << "half 0x" << std::hex << halves[i];
+    }
+}
+
+static void write_pure_model(char const *path, size_t vertex_stride, uint16_t const (*points)[3],
+                             size_t point_count, uint16_t const *indices, size_t index_count,
+                             uint16_t last_marker_index) {
+    FILE *file = fopen(path, "wb");
+    ASSERT_NE(nullptr, file);
+    uint32_t const header[] = {5, 0};
+    fwrite(header, sizeof(header), 1, file);
+    for (size_t i = 0; i < point_count; i++) {
+        uint16_t vertex[16] = {points[i][0], points[i][1], points[i][2]};
+        fwrite(vertex, vertex_stride, 1, file);
+    }
+    // Pad so the index block starts on an 8 byte boundary
+    uint16_t const padding[4] = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF};
+    fwrite(padding, (8 - (8 + point_count * vertex_stride) % 8) % 8, 1, file);
+    fwrite(indices, sizeof(uint16_t), index_count, file);
+    uint16_t const end_marker[] = {0, 1, 2, last_marker_index};
+    fwrite(end_marker, sizeof(end_marker), 1, file);
+    fclose(file);
+}
+
+static void check_pure_model(char const *path, size_t vertex_stride, uint16_t last_marker_index) {
+    // Halves for 0, 1 and -1
+    uint16_t const h0 = 0x0000, h1 = 0x3C00, hm1 = 0xBC00;
+    uint16_t const points[][3] = {{h0, h0, h0}, {h1, h0, h0}, {h0, h1, h0}, {h0, h0, hm1}, {h1, h1, h1}};
+    // Starts with the FIRST_FACE pattern and is long enough to skip past it
+    uint16_t const indices[] = {0, 1, 2, 1, 3, 2, 0, 3, 1, 0, 2, 3,
+                                0, 1, 2, 1, 3, 2, 0, 3, 1, 0, 2, 4};
+    size_t const index_count = sizeof(indices) / sizeof(indices[0]);
+    write_pure_model(path, vertex_stride, points, 5, indices, index_count, last_marker_index);
+
+    Mesh mesh;
+    load_model(path, mesh);
+    remove(path);
+
+    ASSERT_EQ(5u, mesh.positions.size());
+    EXPECT_EQ(glm::vec3(0, 0, 0), mesh.positions[0]);
+    EXPECT_EQ(glm::vec3(1, 0, 0), mesh.positions[1]);
+    EXPECT_EQ(glm::vec3(0, 1, 0), mesh.positions[2]);
+    EXPECT_EQ(glm::vec3(0, 0, -1), mesh.positions[3]);
+    EXPECT_EQ(glm::vec3(1, 1, 1), mesh.positions[4]);
+
+    ASSERT_EQ(index_count, mesh.indices.size());
+    ASSERT_EQ(index_count / 3, mesh.faces_count);
+    for (size_t i = 0; i < index_count; i += 3) {
+        EXPECT_EQ(indices[i + 2], mesh.indices[i]);
+        EXPECT_EQ(indices[i + 1], mesh.indices[i + 1]);
+        EXPECT_EQ(indices[i], mesh.indices[i + 2]);
+    }
+}
+
+TEST(test_loader, pure_model_lod1) {
+    check_pure_model("./mesh_test_LOD1.model", 28, 3);
+}
+
+TEST(test_loader, pure_model_lod3) {
+    check_pure_model("./mesh_test_LOD3.model", 24, 3);
+}
+
+TEST(test_loader, pure_model_half_positions) {
+    char const *path = "./mesh_test_half_LOD1.model";
+    uint16_t const points[][3] = {{0x0000, 0xBC00, 0x3C00}, {0x4000, 0x3C00, 0x0000}, {0xC000, 0x0000, 0x3800}};
+    uint16_t const indices[] = {0, 1, 2, 1, 2, 0, 0, 1, 2, 1, 2, 0, 0, 1, 2, 1, 2, 0, 0, 1, 2};
+    write_pure_model(path, 28, points, 3, indices, sizeof(indices) / sizeof(indices[0]), 3);
+
+    Mesh decoded, halves;
+    load_model(path, decoded);
+    load_model(path, halves, LOAD_HALF_POSITIONS);
+    remove(path);
+
+    ASSERT_TRUE(halves.positions.empty());
+    ASSERT_EQ(3u, halves.half_positions.size());
+    ASSERT_EQ(decoded.indices, halves.indices);
+    ASSERT_EQ(decoded.vertices_count, halves.vertices_count);
+    for (size_t i = 0; i < 3; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            ASSERT_EQ(points[i][axis], halves.half_positions[i][axis]);
+            ASSERT_EQ(decoded.positions[i][axis], convert_float16_to_float32(halves.half_positions[i][axis]));
+        }
+    }
+    ASSERT_EQ(decoded.bounds_min, halves.bounds_min);
+}
+
+TEST(test_loader, load_stats_cover_stages) {
+    char const *path = "./mesh_test_stats_LOD3.model";
+    uint16_t const points[][3] = {{0x0000, 0xBC00, 0x3C00}, {0x4000, 0x3C00, 0x0000}, {0xC000, 0x0000, 0x3800}};
+    uint16_t const indices[] = {0, 1, 2, 1, 2, 0, 0, 1, 2, 1, 2, 0, 0, 1, 2, 1, 2, 0, 0, 1, 2};
+    size_t const index_count = sizeof(indices) / sizeof(indices[0]);
+    write_pure_model(path, 24, points, 3, indices, index_count, 3);
+
+    LoadStats stats;
+    Mesh mesh;
+    load_model(path, mesh, LOAD_NO_CACHE, nullptr, &stats);
+    remove(path);
+    ASSERT_EQ(index_count, mesh.indices.size());
+    ASSERT_EQ(1u, stats.files);
+    ASSERT_EQ(0u, stats.cache_hits);
+    ASSERT_EQ(3u * 6, stats.stages[LOAD_STAGE_HALF_DECODE].bytes);
+    ASSERT_EQ(index_count * 4, stats.stages[LOAD_STAGE_INDEX_BUILD].bytes);
+    ASSERT_GT(stats.stages[LOAD_STAGE_MARKER_SEARCH].bytes, 0u);
+    ASSERT_EQ(0u, stats.stages[LOAD_STAGE_CACHE].bytes);
+    double stage_sum = 0.0;
+    for (unsigned stage = 0; stage < LOAD_STAGE_COUNT; stage++) {
+        ASSERT_GE(stats.stages[stage].ms, 0.0);
+        stage_sum += stats.stages[stage].ms;
+    }
+    ASSERT_LE(stage_sum, stats.total_ms);
+
+    // OBJ files report their size as read and parsed, a repeated load hits the cache
+    LoadStats obj_stats;
+    load_model("./models/pyramid.obj", mesh, LOAD_NO_CACHE, nullptr, &obj_stats);
+    ASSERT_GT(obj_stats.stages[LOAD_STAGE_READ].bytes, 0u);
+    ASSERT_EQ(obj_stats.stages[LOAD_STAGE_READ].bytes, obj_stats.stages[LOAD_STAGE_PARSE].bytes);
+    ASSERT_EQ(0u, obj_stats.stages[LOAD_STAGE_HALF_DECODE].bytes);
+    load_model("./models/pyramid.obj", mesh, 0, nullptr, &obj_stats);
+    size_t const cache_hits = obj_stats.cache_hits;
+    load_model("./models/pyramid.obj", mesh, 0, nullptr, &obj_stats);
+    ASSERT_EQ(3u, obj_stats.files);
+    ASSERT_EQ(cache_hits + 1, obj_stats.cache_hits);
+}
+
+TEST(test_loader, async_loader_matches_sync) {
+    Mesh expected;
+    load_model("./models/octahedron.obj", expected);
+
+    AsyncModelLoader loader;
+    start_async_loader(loader);
+    request_model_load(loader, "./models/octahedron.obj");
+
+    ModelLoadResult result;
+    auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!poll_model_load(loader, result) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::string path;
+    float progress = 0.0f;
+    ASSERT_FALSE(model_load_in_progress(loader, path, progress));
+    stop_async_loader(loader);
+
+    ASSERT_EQ("./models/octahedron.obj", result.path);
+    ASSERT_EQ(expected.positions, result.mesh.positions);
+    ASSERT_EQ(expected.indices, result.mesh.indices);
+    ASSERT_EQ(expected.faces_count, result.mesh.faces_count);
+}
+
+static int finished_loads = 0;
+
+static void count_finished_load() {
+    finished_loads++;
+}
+
+TEST(test_loader, async_loader_reports_finished_loads) {
+    AsyncModelLoader loader;
+    loader.on_finished = count_finished_load;
+    finished_loads = 0;
+    start_async_loader(loader);
+    request_model_load(loader, "./models/tetrahedron.obj");
+
+    // The callback runs before the worker lets go of the result
+    ModelLoadResult result;
+    ASSERT_TRUE(wait_model_load(loader, result));
+    stop_async_loader(loader);
+    ASSERT_EQ(1, finished_loads);
+    ASSERT_FALSE(result.mesh.indices.empty());
+}
+
+TEST(test_loader, cancelled_load_is_empty) {
+    LoadControl control;
+    control.cancelled = true;
+
+    Mesh mesh;
+    load_model("./models/box.obj", mesh, 0, &control);
+    ASSERT_TRUE(mesh.positions.empty());
+    ASSERT_TRUE(mesh.indices.empty());
+    ASSERT_EQ(0u, mesh.faces_count);
+}
+
+static void make_grid_mesh(size_t size, Mesh &mesh) {
+    mesh = Mesh();
+    for (size_t y = 0; y <= size; y++) {
+        for (size_t x = 0; x <= size; x++) {
+            mesh.positions.push_back(glm::vec3(float(x), float(y), 0.0f));
+        }
+    }
+    for (size_t y = 0; y < size; y++) {
+        for (size_t x = 0; x < size; x++) {
+            uint32_t const v = uint32_t(y * (size + 1) + x);
+            uint32_t const quad[6] = {v, v + 1, v + uint32_t(size) + 1, v + 1, v + uint32_t(size) + 2, v + uint32_t(size) + 1};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    // Scatter the faces like a badly ordered export
+    size_t const triangles = mesh.indices.size() / 3;
+    for (size_t t = 0; t < triangles; t++) {
+        size_t const other = (t * 7919) % triangles;
+        for (int i = 0; i < 3; i++) {
+            std::swap(mesh.indices[3 * t + i], mesh.indices[3 * other + i]);
+        }
+    }
+}
+
+static std::vector<std::array<float, 9>> sorted_triangles(Mesh const &mesh) {
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t t = 0; t < mesh.indices.size() / 3; t++) {
+        std::array<float, 9> triangle;
+        for (int i = 0; i < 3; i++) {
+            glm::vec3 const &p = mesh.positions[mesh.indices[3 * t + i]];
+            triangle[3 * i + 0] = p.x;
+            triangle[3 * i + 1] = p.y;
+            triangle[3 * i + 2] = p.z;
+        }
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+TEST(test_loader, acmr_of_strip) {
+    // Every triangle after the first reuses two cached vertices
+    std::vector<uint32_t> indices = {0, 1, 2, 2, 1, 3, 2, 3, 4, 4, 3, 5};
+    ASSERT_FLOAT_EQ(6.0f / 4.0f, compute_acmr(indices, 6));
+    // A single entry only catches the repeated 2 and 3
+    ASSERT_FLOAT_EQ(10.0f / 4.0f, compute_acmr(indices, 6, 1));
+}
+
+TEST(test_loader, optimize_mesh_keeps_faces) {
+    Mesh mesh;
+    make_grid_mesh(64, mesh);
+    auto const expected = sorted_triangles(mesh);
+
+    MeshOptimizeStats stats;
+    optimize_mesh(mesh, &stats);
+    ASSERT_TRUE(mesh.optimized);
+    ASSERT_LT(stats.acmr_after, stats.acmr_before);
+    ASSERT_LT(stats.acmr_after, 1.0f);
+    ASSERT_FLOAT_EQ(stats.acmr_after, compute_acmr(mesh.indices, mesh.positions.size()));
+    ASSERT_EQ(expected, sorted_triangles(mesh));
+
+    // Vertices come in the order the faces first use them
+    uint32_t next = 0;
+    for (auto index : mesh.indices) {
+        ASSERT_LE(index, next);
+        if (index == next) {
+            next++;
+        }
+    }
+    ASSERT_EQ(mesh.positions.size(), next);
+}
+
+TEST(test_loader, mesh_lods_simplify) {
+    // Gently curved sheet so simplification has some error to report
+    Mesh mesh;
+    make_grid_mesh(64, mesh);
+    for (auto &position : mesh.positions) {
+        position.z = std::sin(position.x * 0.1f) * std::cos(position.y * 0.1f);
+    }
+    mesh.model_size = 64.0f;
+
+    build_mesh_lods(mesh);
+    ASSERT_GE(mesh.lods.size(), 3u);
+    size_t previous = mesh.indices.size();
+    float previous_error = 0.0f;
+    for (auto const &lod : mesh.lods) {
+        ASSERT_LT(lod.indices.size(), previous);
+        ASSERT_GE(lod.error, previous_error);
+        ASSERT_LT(lod.error, 1.0f);
+        for (auto index : lod.indices) {
+            ASSERT_LT(index, mesh.positions.size());
+        }
+        previous = lod.indices.size();
+        previous_error = lod.error;
+    }
+
+    // Close up needs the full mesh, far away the coarsest level will do
+    ASSERT_EQ(0u, select_mesh_lod(mesh, 33.0f, 45.0f, 720.0f));
+    ASSERT_EQ(mesh.lods.size(), select_mesh_lod(mesh, 100000.0f, 45.0f, 720.0f));
+
+    // Face ids of each level follow on from the one before
+    ASSERT_EQ(0u, mesh_lod_first_face(mesh, 0));
+    ASSERT_EQ(mesh.indices.size() / 3, mesh_lod_first_face(mesh, 1));
+    ASSERT_EQ((mesh.indices.size() + mesh.lods[0].indices.size()) / 3, mesh_lod_first_face(mesh, 2));
+
+    // Failed loads leave nothing to simplify
+    Mesh empty;
+    build_mesh_lods(empty);
+    ASSERT_TRUE(empty.lods.empty());
+}
+
+TEST(test_loader, mesh_cache_keeps_lods) {
+    Mesh mesh;
+    load_model("./models/box.obj", mesh, LOAD_LODS);
+    mesh.lods.resize(1);
+    mesh.lods[0].indices.assign(mesh.indices.begin(), mesh.indices.begin() + 3);
+    mesh.lods[0].error = 0.5f;
+    ASSERT_TRUE(save_mesh_cache("./models/box.obj", mesh));
+
+    Mesh cached;
+    ASSERT_TRUE(load_mesh_cache("./models/box.obj", cached));
+    ASSERT_EQ(1u, cached.lods.size());
+    ASSERT_EQ(mesh.lods[0].indices, cached.lods[0].indices);
+    ASSERT_FLOAT_EQ(0.5f, cached.lods[0].error);
+
+    // Plain loads do not pick up levels left in the cache
+    Mesh plain;
+    load_model("./models/box.obj", plain);
+    ASSERT_TRUE(plain.lods.empty());
+    ASSERT_EQ(mesh.indices, plain.indices);
+}
+
+TEST(test_loader, meshlets_cover_mesh) {
+    Mesh mesh;
+    make_grid_mesh(64, mesh);
+    auto const expected = sorted_triangles(mesh);
+
+    build_meshlets(mesh);
+    ASSERT_EQ(expected, sorted_triangles(mesh));
+    ASSERT_EQ((mesh.indices.size() / 3 + MESHLET_MAX_TRIANGLES - 1) / MESHLET_MAX_TRIANGLES, mesh.meshlets.size());
+    uint32_t next = 0;
+    for (auto const &meshlet : mesh.meshlets) {
+        ASSERT_EQ(next, meshlet.first_index);
+        ASSERT_LE(meshlet.index_count, 3 * MESHLET_MAX_TRIANGLES);
+        for (uint32_t i = meshlet.first_index; i < meshlet.first_index + meshlet.index_count; i++) {
+            glm::vec3 const offset = mesh.positions[mesh.indices[i]] - meshlet.center;
+            ASSERT_LE(glm::length(offset), meshlet.radius * 1.0001f);
+        }
+        // Flat sheet facing +z: every normal is the cone axis
+        ASSERT_NEAR(1.0f, meshlet.cone_axis.z, 1e-5f);
+        ASSERT_NEAR(0.0f, meshlet.cone_cutoff, 1e-3f);
+        next += meshlet.index_count;
+    }
+    ASSERT_EQ(mesh.indices.size(), next);
+}
+
+TEST(test_loader, meshlets_culling) {
+    Mesh mesh;
+    make_grid_mesh(64, mesh);
+    build_meshlets(mesh);
+
+    // Looking down at the sheet from above its center sees all of it
+    glm::vec3 const above(32.0f, 32.0f, 100.0f);
+    glm::mat4 const projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 1000.0f);
+    Frustum frustum;
+    extract_frustum(projection * glm::lookAt(above, glm::vec3(32.0f, 32.0f, 0.0f), glm::vec3(0, 1, 0)), frustum);
+    std::vector<MeshletRange> ranges;
+    ASSERT_EQ(mesh.meshlets.size(), cull_meshlets(mesh.meshlets, frustum, above, true, ranges));
+    ASSERT_EQ(1u, ranges.size());
+    ASSERT_EQ(mesh.indices.size(), ranges[0].index_count);
+
+    // From below only the back of every face shows
+    glm::vec3 const below(32.0f, 32.0f, -100.0f);
+    extract_frustum(projection * glm::lookAt(below, glm::vec3(32.0f, 32.0f, 0.0f), glm::vec3(0, 1, 0)), frustum);
+    ASSERT_EQ(mesh.meshlets.size(), cull_meshlets(mesh.meshlets, frustum, below, false, ranges));
+    ASSERT_EQ(0u, cull_meshlets(mesh.meshlets, frustum, below, true, ranges));
+    ASSERT_TRUE(ranges.empty());
+
+    // Looking away from the sheet sees nothing
+    extract_frustum(projection * glm::lookAt(above, glm::vec3(32.0f, 32.0f, 200.0f), glm::vec3(0, 1, 0)), frustum);
+    ASSERT_EQ(0u, cull_meshlets(mesh.meshlets, frustum, above, false, ranges));
+}
+
+TEST(test_loader, scene_shares_meshes) {
+    std::string const path = "./test_instances.scene";
+    {
+        std::ofstream file(path);
+        file << "# three boxes and a pyramid\n"
+             << "models/box.obj 0 0 0\n"
+             << "models/pyramid.obj 10 0 0\n"
+             << "models/box.obj 20 0 0\n"
+             << "models/box.obj 2 0 0 0  0 2 0 0  0 0 2 -20\n";
+    }
+    Scene scene;
+    ASSERT_TRUE(load_scene(path, scene));
+    remove(path.c_str());
+
+    ASSERT_EQ(2u, scene.meshes.size());
+    ASSERT_EQ(4u, scene.instances.size());
+    ASSERT_EQ("./models/box.obj", scene.mesh_paths[0]);
+
+    Mesh box;
+    load_model("./models/box.obj", box);
+    ASSERT_EQ(box.indices, scene.meshes[0].indices);
+
+    std::vector<glm::mat4> transforms;
+    scene_mesh_transforms(scene, 0, transforms);
+    ASSERT_EQ(3u, transforms.size());
+    ASSERT_FLOAT_EQ(20.0f, transforms[1][3][0]);
+    ASSERT_FLOAT_EQ(2.0f, transforms[2][0][0]);
+    ASSERT_FLOAT_EQ(-20.0f, transforms[2][3][2]);
+
+    // Bounds cover every transformed instance
+    ASSERT_FLOAT_EQ(box.bounds_max.x + 20.0f, scene.bounds_max.x);
+    ASSERT_FLOAT_EQ(box.bounds_min.z * 2.0f - 20.0f, scene.bounds_min.z);
+}
+
+TEST(test_loader, scene_forwards_load_control) {
+    std::string const path = "./test_control.scene";
+    {
+        std::ofstream file(path);
+        file << "models/box.obj 0 0 0\n"
+             << "models/pyramid.obj 10 0 0\n";
+    }
+    Scene scene;
+    LoadControl control;
+    ASSERT_TRUE(load_scene(path, scene, 0, &control));
+    ASSERT_FLOAT_EQ(1.0f, control.progress);
+    ASSERT_FLOAT_EQ(0.0f, control.progress_offset);
+    ASSERT_FLOAT_EQ(1.0f, control.progress_scale);
+
+    control.cancelled = true;
+    ASSERT_FALSE(load_scene(path, scene, 0, &control));
+    remove(path.c_str());
+    ASSERT_TRUE(scene.meshes.empty());
+}
+
+TEST(test_loader, scene_rejects_bad_lines) {
+    std::string const path = "./test_invalid.scene";
+    {
+        std::ofstream file(path);
+        file << "models/box.obj 1 2\n";
+    }
+    Scene scene;
+    ASSERT_FALSE(load_scene(path, scene));
+    remove(path.c_str());
+    ASSERT_TRUE(scene.instances.empty());
+}
+
+TEST(test_loader, unique_edges_of_closed_mesh) {
+    Mesh mesh;
+    load_model("./models/box.obj", mesh);
+
+    // Every edge of a closed mesh is shared by two faces
+    ASSERT_EQ(mesh.faces_count * 3 / 2, mesh.edges_count);
+    ASSERT_EQ(mesh.edges_count * 2, mesh.edges.size());
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t i = 0; i < mesh.edges.size(); i += 2) {
+        ASSERT_LT(mesh.edges[i], mesh.edges[i + 1]);
+        edges.push_back(std::make_pair(mesh.edges[i], mesh.edges[i + 1]));
+    }
+    std::sort(edges.begin(), edges.end());
+    ASSERT_TRUE(std::adjacent_find(edges.begin(), edges.end()) == edges.end());
+}
+
+TEST(test_loader, unique_edges_parallel_matches_serial) {
+    size_t const size = 256;
+    Mesh mesh;
+    make_grid_mesh(size, mesh);
+    ASSERT_GT(mesh.indices.size() / 3, EDGE_PARALLEL_TRIANGLES);
+
+    // Rows, columns and one diagonal per quad
+    std::vector<uint32_t> serial, parallel;
+    extract_edges(mesh.indices, serial, 1);
+    extract_edges(mesh.indices, parallel, 4);
+    ASSERT_EQ(2 * (2 * size * (size + 1) + size * size), serial.size());
+    ASSERT_EQ(serial.size(), parallel.size());
+
+    std::vector<uint64_t> serial_keys, parallel_keys;
+    for (size_t i = 0; i < serial.size(); i += 2) {
+        serial_keys.push_back((uint64_t(serial[i]) << 32) | serial[i + 1]);
+        parallel_keys.push_back((uint64_t(parallel[i]) << 32) | parallel[i + 1]);
+    }
+    std::sort(serial_keys.begin(), serial_keys.end());
+    std::sort(parallel_keys.begin(), parallel_keys.end());
+    ASSERT_EQ(serial_keys, parallel_keys);
+}
+
+TEST(test_loader, generated_meshes_are_seeded) {
+    GeneratorOptions options;
+    options.triangles = 5000;
+    for (GeneratedShape shape : {SHAPE_SPHERE, SHAPE_TERRAIN, SHAPE_SOUP}) {
+        options.shape = shape;
+        options.seed = 7;
+        Mesh first, second, other;
+        generate_mesh(options, first);
+        generate_mesh(options, second);
+        options.seed = 8;
+        generate_mesh(options, other);
+
+        ASSERT_EQ(first.positions, second.positions);
+        ASSERT_EQ(first.indices, second.indices);
+        ASSERT_NE(first.positions, other.positions);
+        ASSERT_GE(first.faces_count, options.triangles);
+        for (uint32_t index : first.indices) {
+            ASSERT_LT(index, first.positions.size());
+        }
+        for (auto const &position : first.positions) {
+            for (int axis = 0; axis < 3; axis++) {
+                ASSERT_LE(std::fabs(position[axis]), 1.0f + options.noise);
+            }
+        }
+    }
+}
+
+TEST(test_loader, generated_obj_roundtrip) {
+    std::string const path = "./generated_test.obj";
+    GeneratorOptions options;
+    options.shape = SHAPE_TERRAIN;
+    options.triangles = 2001;
+    ASSERT_TRUE(write_generated_mesh(path, options));
+    Mesh generated, loaded;
+    generate_mesh(options, generated);
+    load_model(path, loaded, LOAD_NO_CACHE);
+    remove(path.c_str());
+
+    ASSERT_EQ(options.triangles, loaded.faces_count);
+    ASSERT_EQ(generated.indices, loaded.indices);
+    ASSERT_EQ(generated.positions.size(), loaded.positions.size());
+    for (size_t i = 0; i < loaded.positions.size(); i++) {
+        ASSERT_LT(glm::length(generated.positions[i] - loaded.positions[i]), 1e-5f);
+    }
+}
+
+TEST(test_loader, generated_pure_model_roundtrip) {
+    std::string const path = "./generated_test_LOD1.model";
+    GeneratorOptions options;
+    options.shape = SHAPE_SPHERE;
+    options.triangles = 200000;
+    ASSERT_TRUE(write_generated_mesh(path, options));
+    Mesh loaded;
+    load_model(path, loaded, LOAD_NO_CACHE);
+    remove(path.c_str());
+
+    // The 16 bit indices cap the vertices, the faces repeat past that
+    ASSERT_EQ(options.triangles, loaded.faces_count);
+    ASSERT_LE(loaded.vertices_count, PURE_MAX_VERTICES);
+    for (int axis = 0; axis < 3; axis++) {
+        ASSERT_GE(loaded.bounds_min[axis], -1.0f - options.noise - 1e-2f);
+        ASSERT_LE(loaded.bounds_max[axis], 1.0f + options.noise + 1e-2f);
+    }
+}
+
+TEST(test_loader, bounds_of_off_origin_points) {
+    // Entirely on one side of the origin, bounds must not be clamped to 0
+    std::vector<glm::vec3> positions = {{12, -6, 4}, {10, -8, 3.5f}, {11, -7, 3}, {10.5f, -6.5f, 3.25f}, {11.5f, -7.5f, 4}};
+    MeshBounds bounds;
+    calculate_bounds(positions, bounds);
+    ASSERT_EQ(glm::vec3(10, -8, 3), bounds.min);
+    ASSERT_EQ(glm::vec3(12, -6, 4), bounds.max);
+    ASSERT_FLOAT_EQ(std::sqrt(1.0f + 1.0f + 0.25f), bounds.radius);
+
+    float model_size = 0.0f;
+    glm::vec3 model_center, bounds_min, bounds_max;
+    calculate_size_and_center(positions, model_size, model_center, bounds_min, bounds_max);
+    ASSERT_EQ(2.0f, model_size);
+    ASSERT_EQ(glm::vec3(11, -7, 3.5f), model_center);
+}
+
+TEST(test_loader, bounds_parallel_matches_serial) {
+    std::vector<glm::vec3> positions(BOUNDS_PARALLEL_VERTICES + 7);
+    for (size_t i = 0; i < positions.size(); i++) {
+        float const t = static_cast<float>(i);
+        positions[i] = glm::vec3(std::sin(t) * 3.0f + 100.0f, std::cos(t * 0.7f) - 50.0f, std::fmod(t, 13.0f));
+    }
+    positions[5].y = NAN;
+
+    MeshBounds serial, parallel, automatic;
+    calculate_bounds(positions, serial, 1);
+    calculate_bounds(positions, parallel, 5);
+    calculate_bounds(positions, automatic);
+    ASSERT_EQ(serial.min, parallel.min);
+    ASSERT_EQ(serial.max, parallel.max);
+    ASSERT_EQ(serial.radius, parallel.radius);
+    ASSERT_EQ(serial.radius, automatic.radius);
+
+    glm::vec3 low = positions[0], high = positions[0];
+    for (size_t i = 0; i < positions.size(); i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (!std::isnan(positions[i][axis])) {
+                low[axis] = std::min(low[axis], positions[i][axis]);
+                high[axis] = std::max(high[axis], positions[i][axis]);
+            }
+        }
+    }
+    ASSERT_EQ(low, serial.min);
+    ASSERT_EQ(high, serial.max);
+}
+
+TEST(test_loader, loaded_mesh_sphere_holds_vertices) {
+    Mesh mesh;
+    load_model("./models/pyramid.obj", mesh, LOAD_NO_CACHE);
+    ASSERT_GT(mesh.bounding_radius, 0.0f);
+    // Never larger than the sphere through the box corners
+    ASSERT_LE(mesh.bounding_radius, glm::length(mesh.bounds_max - mesh.bounds_min) * 0.5f * (1.0f + 1e-6f));
+    for (auto const &position : mesh.positions) {
+        ASSERT_LE(glm::length(position - mesh.model_center), mesh.bounding_radius * (1.0f + 1e-6f));
+    }
+}
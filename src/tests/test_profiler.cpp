@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "../utils/profiler.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST(test_profiler, history_sums_samples_per_frame) {
+    FrameProfiler profiler;
+    for (int frame = 0; frame < 3; frame++) {
+        begin_profile_frame(profiler);
+        add_profile_sample(profiler, STAGE_DRAW, profiler.frame, 0.0, 1.0);
+        add_profile_sample(profiler, STAGE_DRAW, profiler.frame, 1.0, 2.0 + frame);
+        end_profile_frame(profiler);
+    }
+    float average = 0.0f, worst = 0.0f;
+    profile_stage_summary(profiler, STAGE_DRAW, average, worst);
+    ASSERT_FLOAT_EQ(4.0f, average);
+    ASSERT_FLOAT_EQ(5.0f, worst);
+    ASSERT_EQ(3u, profiler.frame);
+}
+
+TEST(test_profiler, late_samples_land_in_their_frame) {
+    FrameProfiler profiler;
+    for (int frame = 0; frame < 4; frame++) {
+        begin_profile_frame(profiler);
+        end_profile_frame(profiler);
+    }
+    // A GPU result of frame 1 read during frame 4
+    begin_profile_frame(profiler);
+    add_profile_sample(profiler, STAGE_GPU_DRAW, 1, 0.0, 8.0);
+    end_profile_frame(profiler);
+    size_t const slot = (profiler.history_next + PROFILE_HISTORY - 4) % PROFILE_HISTORY;
+    ASSERT_FLOAT_EQ(8.0f, profiler.history[STAGE_GPU_DRAW][slot]);
+    float average = 0.0f, worst = 0.0f;
+    profile_stage_summary(profiler, STAGE_GPU_DRAW, average, worst);
+    ASSERT_FLOAT_EQ(8.0f, worst);
+}
+
+TEST(test_profiler, records_only_requested_frames) {
+    FrameProfiler profiler;
+    begin_profile_frame(profiler);
+    end_profile_frame(profiler);
+    start_profile_recording(profiler, 2);
+    for (int frame = 0; frame < 3; frame++) {
+        begin_profile_frame(profiler);
+        add_profile_sample(profiler, STAGE_INPUT, profiler.frame, 0.0, 0.5);
+        end_profile_frame(profiler);
+    }
+    // Late result of the last recorded frame
+    add_profile_sample(profiler, STAGE_GPU_DRAW, 2, 0.0, 3.0);
+    // Input and frame events of frames 1 and 2, then the GPU one
+    ASSERT_EQ(5u, profiler.recorded.size());
+    ASSERT_EQ(1u, profiler.recorded.front().frame);
+    ASSERT_EQ(unsigned(STAGE_GPU_DRAW), profiler.recorded.back().stage);
+
+    std::string const path = "profiler_test_trace.json";
+    ASSERT_TRUE(write_chrome_trace(profiler, path));
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    std::remove(path.c_str());
+    std::string const json = contents.str();
+    ASSERT_EQ(0u, json.find("{\"traceEvents\":["));
+    ASSERT_NE(std::string::npos, json.find("\"name\":\"GPU draw\",\"ph\":\"X\",\"ts\":0.000,\"dur\":3000.000"));
+    ASSERT_EQ(std::string::npos, json.find("},\n]"));
+}
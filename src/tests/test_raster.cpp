@@ -0,0 +1,208 @@
+#include "gtest/gtest.h"
+#include "../raster/software_raster.hpp"
+
+// Quad spanning x and y from -extent to extent at depth z, two triangles
+static void add_quad(Mesh &mesh, float extent, float z) {
+    uint32_t const first = static_cast<uint32_t>(mesh.positions.size());
+    mesh.positions.push_back(glm::vec3(-extent, -extent, z));
+    mesh.positions.push_back(glm::vec3(extent, -extent, z));
+    mesh.positions.push_back(glm::vec3(extent, extent, z));
+    mesh.positions.push_back(glm::vec3(-extent, extent, z));
+    uint32_t const quad[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+    mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+}
+
+// Rectangle from x = left to the right edge of clip space, full height, at depth z
+static void add_right_rect(Mesh &mesh, float left, float z) {
+    uint32_t const first = static_cast<uint32_t>(mesh.positions.size());
+    mesh.positions.push_back(glm::vec3(left, -1.0f, z));
+    mesh.positions.push_back(glm::vec3(1.0f, -1.0f, z));
+    mesh.positions.push_back(glm::vec3(1.0f, 1.0f, z));
+    mesh.positions.push_back(glm::vec3(left, 1.0f, z));
+    uint32_t const quad[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+    mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+}
+
+static size_t count_color(RasterTarget const &target, uint8_t r, uint8_t g, uint8_t b) {
+    size_t count = 0;
+    for (size_t i = 0; i < target.color.size(); i += 3) {
+        if (target.color[i] == r && target.color[i + 1] == g && target.color[i + 2] == b) {
+            count++;
+        }
+    }
+    return count;
+}
+
+TEST(test_raster, fills_shared_edges_once) {
+    // Clip space quad covering the whole target
+    Mesh mesh;
+    add_quad(mesh, 1.0f, 0.0f);
+    RasterTarget target;
+    resize_raster_target(target, 97, 61);
+    // Face 0 hashes to black, so the background is white
+    clear_raster_target(target, glm::vec3(1.0f));
+    std::vector<glm::mat4> const identity(1, glm::mat4(1.0f));
+    draw_raster_mesh(target, mesh, glm::mat4(1.0f), identity, COLOR_BY_FACE);
+
+    // Every pixel belongs to exactly one of the two faces
+    for (float const depth : target.depth) {
+        ASSERT_FLOAT_EQ(0.5f, depth);
+    }
+    ASSERT_EQ(0u, count_color(target, 255, 255, 255));
+    size_t const first = count_color(target, target.color[0], target.color[1], target.color[2]);
+    size_t const last_pixel = target.color.size() - 3;
+    size_t const second = count_color(target, target.color[last_pixel], target.color[last_pixel + 1],
+                                      target.color[last_pixel + 2]);
+    ASSERT_EQ(size_t(97 * 61), first + second);
+}
+
+TEST(test_raster, depth_test_ignores_draw_order) {
+    Mesh near_first, far_first;
+    add_quad(near_first, 0.5f, -0.5f);
+    add_quad(near_first, 0.8f, 0.5f);
+    add_quad(far_first, 0.8f, 0.5f);
+    add_quad(far_first, 0.5f, -0.5f);
+    std::vector<glm::mat4> const identity(1, glm::mat4(1.0f));
+
+    RasterTarget a, b;
+    resize_raster_target(a, 64, 64);
+    resize_raster_target(b, 64, 64);
+    clear_raster_target(a, glm::vec3(0.0f));
+    clear_raster_target(b, glm::vec3(0.0f));
+    draw_raster_mesh(a, near_first, glm::mat4(1.0f), identity, COLOR_BY_VERTEX);
+    draw_raster_mesh(b, far_first, glm::mat4(1.0f), identity, COLOR_BY_VERTEX);
+    ASSERT_EQ(a.depth, b.depth);
+    ASSERT_FLOAT_EQ(0.25f, a.depth[32 * 64 + 32]);
+    ASSERT_FLOAT_EQ(0.75f, a.depth[32 * 64 + 8]);
+    ASSERT_FLOAT_EQ(1.0f, a.depth[0]);
+}
+
+TEST(test_raster, threads_match_single_thread) {
+    // Many small triangles crossing tile borders, seen in perspective
+    Mesh mesh;
+    for (int i = 0; i < 200; i++) {
+        add_quad(mesh, 0.05f + 0.01f * (i % 50), -0.01f * i);
+    }
+    glm::mat4 const mvp = glm::perspective(glm::radians(60.0f), 1.5f, 0.1f, 10.0f) *
+                          glm::lookAt(glm::vec3(0.3f, 0.2f, 1.0f), glm::vec3(0.0f), glm::vec3(0, 1, 0));
+    std::vector<glm::mat4> transforms(2, glm::mat4(1.0f));
+    transforms[1][3] = glm::vec4(0.2f, 0.0f, -0.5f, 1.0f);
+
+    RasterTarget single, threaded;
+    resize_raster_target(single, 300, 200);
+    resize_raster_target(threaded, 300, 200);
+    clear_raster_target(single, glm::vec3(0.29f));
+    clear_raster_target(threaded, glm::vec3(0.29f));
+    draw_raster_mesh(single, mesh, mvp, transforms, COLOR_BY_VERTEX, 0, 1);
+    draw_raster_mesh(threaded, mesh, mvp, transforms, COLOR_BY_VERTEX, 0, 4);
+    ASSERT_EQ(single.color, threaded.color);
+    ASSERT_EQ(single.depth, threaded.depth);
+    ASSERT_LT(count_color(single, 74, 74, 74), size_t(300 * 200));
+}
+
+TEST(test_raster, tiles_keep_to_their_pixels) {
+    // Rectangles starting 1 to 3 pixels before a tile edge, so the first 4
+    // pixels of each row cross into the next tile. The nearest are drawn
+    // first, every later one has to fail the depth test there.
+    int const width = RASTER_TILE_SIZE * 4, height = RASTER_TILE_SIZE;
+    Mesh mesh;
+    for (int i = 0; i < 96; i++) {
+        float const left_pixel = float(RASTER_TILE_SIZE - 1 - i % 3);
+        add_right_rect(mesh, left_pixel / width * 2.0f - 1.0f, -0.9f + 0.015f * i);
+    }
+    std::vector<glm::mat4> const identity(1, glm::mat4(1.0f));
+
+    RasterTarget single;
+    resize_raster_target(single, width, height);
+    clear_raster_target(single, glm::vec3(1.0f));
+    draw_raster_mesh(single, mesh, glm::mat4(1.0f), identity, COLOR_BY_FACE, 0, 1);
+    // The first rectangle is in front from its left edge on
+    ASSERT_FLOAT_EQ(0.05f, single.depth[RASTER_TILE_SIZE]);
+    ASSERT_FLOAT_EQ(0.05f, single.depth[width - 1]);
+    ASSERT_FLOAT_EQ(1.0f, single.depth[RASTER_TILE_SIZE - 4]);
+
+    // Threads only race if a tile writes past its edge, so try a few times
+    for (int attempt = 0; attempt < 20; attempt++) {
+        RasterTarget threaded;
+        resize_raster_target(threaded, width, height);
+        clear_raster_target(threaded, glm::vec3(1.0f));
+        draw_raster_mesh(threaded, mesh, glm::mat4(1.0f), identity, COLOR_BY_FACE, 0, 4);
+        ASSERT_EQ(single.depth, threaded.depth);
+        ASSERT_EQ(single.color, threaded.color);
+    }
+}
+
+TEST(test_raster, clips_to_near_plane) {
+    // A floor running from behind the camera to far ahead
+    Mesh mesh;
+    mesh.positions.push_back(glm::vec3(-1.0f, -0.5f, 5.0f));
+    mesh.positions.push_back(glm::vec3(1.0f, -0.5f, 5.0f));
+    mesh.positions.push_back(glm::vec3(0.0f, -0.5f, -5.0f));
+    mesh.indices.push_back(0);
+    mesh.indices.push_back(1);
+    mesh.indices.push_back(2);
+    glm::mat4 const mvp = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f) *
+                          glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0, 1, 0));
+
+    RasterTarget target;
+    resize_raster_target(target, 64, 64);
+    clear_raster_target(target, glm::vec3(1.0f));
+    draw_raster_mesh(target, mesh, mvp, std::vector<glm::mat4>(1, glm::mat4(1.0f)), COLOR_BY_FACE);
+
+    // Only the lower half sees the floor, its near edge runs off the bottom
+    size_t const background = count_color(target, 255, 255, 255);
+    ASSERT_LT(background, size_t(64 * 64));
+    ASSERT_GE(background, size_t(64 * 32));
+    ASSERT_LT(target.depth[0 * 64 + 32], 1.0f);
+    ASSERT_FLOAT_EQ(1.0f, target.depth[63 * 64 + 32]);
+}
+
+TEST(test_raster, culled_ranges_keep_face_colors) {
+    // Flat grid over the whole target, no pixel is covered twice
+    Mesh mesh;
+    int const cells = 32;
+    for (int y = 0; y < cells; y++) {
+        for (int x = 0; x < cells; x++) {
+            float const step = 2.0f / cells;
+            uint32_t const first = static_cast<uint32_t>(mesh.positions.size());
+            mesh.positions.push_back(glm::vec3(-1.0f + x * step, -1.0f + y * step, 0.0f));
+            mesh.positions.push_back(glm::vec3(-1.0f + (x + 1) * step, -1.0f + y * step, 0.0f));
+            mesh.positions.push_back(glm::vec3(-1.0f + (x + 1) * step, -1.0f + (y + 1) * step, 0.0f));
+            mesh.positions.push_back(glm::vec3(-1.0f + x * step, -1.0f + (y + 1) * step, 0.0f));
+            uint32_t const quad[6] = {first, first + 1, first + 2, first, first + 2, first + 3};
+            mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+        }
+    }
+    build_meshlets(mesh);
+    ASSERT_GT(mesh.meshlets.size(), 2u);
+
+    RasterTarget full, culled;
+    resize_raster_target(full, 128, 128);
+    resize_raster_target(culled, 128, 128);
+    clear_raster_target(full, glm::vec3(1.0f));
+    clear_raster_target(culled, glm::vec3(1.0f));
+    draw_raster_mesh(full, mesh, glm::mat4(1.0f), std::vector<glm::mat4>(1, glm::mat4(1.0f)), COLOR_BY_FACE);
+
+    // Every other meshlet, so no range starts at face 0
+    std::vector<MeshletRange> ranges;
+    for (size_t i = 1; i < mesh.meshlets.size(); i += 2) {
+        MeshletRange range;
+        range.first_index = mesh.meshlets[i].first_index;
+        range.index_count = mesh.meshlets[i].index_count;
+        ranges.push_back(range);
+    }
+    draw_raster_mesh_ranges(culled, mesh, glm::mat4(1.0f), glm::mat4(1.0f), COLOR_BY_FACE, ranges);
+
+    size_t drawn = 0;
+    for (size_t i = 0; i < culled.depth.size(); i++) {
+        if (culled.depth[i] == 1.0f) {
+            continue;
+        }
+        drawn++;
+        ASSERT_EQ(full.color[3 * i], culled.color[3 * i]);
+        ASSERT_EQ(full.color[3 * i + 1], culled.color[3 * i + 1]);
+        ASSERT_EQ(full.color[3 * i + 2], culled.color[3 * i + 2]);
+    }
+    ASSERT_GT(drawn, 0u);
+    ASSERT_LT(drawn, culled.depth.size());
+}
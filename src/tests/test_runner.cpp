@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 
 int main() {
+    // Keep mesh cache entries written by the tests out of the user's cache
+    setenv("MODEL_VIEWER_CACHE_DIR", "./mesh_cache", 1);
     testing::InitGoogleTest();
     std::cout << RUN_ALL_TESTS() << " TESTS FAILED!" << std::endl;
 }
@@ -0,0 +1,31 @@
+#ifndef PARALLEL_HPP_
+#define PARALLEL_HPP_
+
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Runs task(0) to task(task_count - 1) on their own threads and waits
+ * for all of them
+ *
+ * The calling thread takes task 0, so a single task never starts a thread.
+ *
+ * @param task_count Number of tasks, 0 does nothing
+ * @param task Callable taking the task index as a size_t
+ */
+template <typename Function>
+void run_parallel(size_t task_count, Function const &task) {
+    std::vector<std::thread> workers;
+    workers.reserve(task_count);
+    for (size_t i = 1; i < task_count; i++) {
+        workers.emplace_back(task, i);
+    }
+    if (task_count > 0) {
+        task(0);
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+#endif  // PARALLEL_HPP_
@@ -0,0 +1,118 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+static char const *const STAGE_NAMES[PROFILE_STAGE_COUNT] = {"Frame", "Input", "ImGui", "Upload",
+                                                             "Draw",  "Swap",  "GPU draw"};
+
+double profile_now_ms(FrameProfiler const &profiler) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - profiler.epoch).count();
+}
+
+void begin_profile_frame(FrameProfiler &profiler) {
+    std::fill(profiler.frame_totals, profiler.frame_totals + PROFILE_STAGE_COUNT, 0.0);
+    profiler.frame_start_ms = profile_now_ms(profiler);
+}
+
+void end_profile_frame(FrameProfiler &profiler) {
+    double const now = profile_now_ms(profiler);
+    add_profile_sample(profiler, STAGE_FRAME, profiler.frame, profiler.frame_start_ms, now - profiler.frame_start_ms);
+    // GPU timings usually arrive a few frames later and are added to the history then
+    for (unsigned stage = 0; stage < PROFILE_STAGE_COUNT; stage++) {
+        profiler.history[stage][profiler.history_next] = static_cast<float>(profiler.frame_totals[stage]);
+    }
+    profiler.history_next = (profiler.history_next + 1) % PROFILE_HISTORY;
+    profiler.frame++;
+}
+
+void add_profile_sample(FrameProfiler &profiler, unsigned stage, uint64_t frame, double start_ms,
+                        double duration_ms) {
+    if (stage >= PROFILE_STAGE_COUNT) {
+        return;
+    }
+    if (frame == profiler.frame) {
+        profiler.frame_totals[stage] += duration_ms;
+    } else if (frame < profiler.frame && profiler.frame - frame < PROFILE_HISTORY) {
+        size_t const age = static_cast<size_t>(profiler.frame - frame);
+        size_t const slot = (profiler.history_next + PROFILE_HISTORY - age) % PROFILE_HISTORY;
+        profiler.history[stage][slot] += static_cast<float>(duration_ms);
+    }
+    // Late samples of recorded frames still belong to the recording
+    if (frame >= profiler.record_begin && frame < profiler.record_end) {
+        ProfileEvent event;
+        event.stage = stage;
+        event.frame = frame;
+        event.start_ms = start_ms;
+        event.duration_ms = duration_ms;
+        profiler.recorded.push_back(event);
+    }
+}
+
+void start_profile_recording(FrameProfiler &profiler, size_t frames) {
+    profiler.recorded.clear();
+    profiler.record_begin = profiler.frame;
+    profiler.record_end = profiler.frame + frames;
+}
+
+void profile_stage_summary(FrameProfiler const &profiler, unsigned stage, float &average, float &worst) {
+    average = 0.0f;
+    worst = 0.0f;
+    if (stage >= PROFILE_STAGE_COUNT) {
+        return;
+    }
+    size_t const count = static_cast<size_t>(std::min<uint64_t>(profiler.frame, PROFILE_HISTORY));
+    if (count == 0) {
+        return;
+    }
+    double sum = 0.0;
+    for (size_t i = 1; i <= count; i++) {
+        float const value = profiler.history[stage][(profiler.history_next + PROFILE_HISTORY - i) % PROFILE_HISTORY];
+        sum += value;
+        worst = std::max(worst, value);
+    }
+    average = static_cast<float>(sum / count);
+}
+
+char const *profile_stage_name(unsigned stage) {
+    return stage < PROFILE_STAGE_COUNT ? STAGE_NAMES[stage] : "";
+}
+
+bool write_chrome_trace(FrameProfiler const &profiler, std::string const &path) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Can't write trace %s\n", path.c_str());
+        return false;
+    }
+    // Complete events in microseconds, GPU work on its own track
+    fprintf(file, "{\"traceEvents\":[\n");
+    for (size_t i = 0; i < profiler.recorded.size(); i++) {
+        ProfileEvent const &event = profiler.recorded[i];
+        fprintf(file,
+                "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+                "\"args\":{\"frame\":%llu}}%s\n",
+                profile_stage_name(event.stage), event.start_ms * 1000.0, event.duration_ms * 1000.0,
+                event.stage == STAGE_GPU_DRAW ? 2 : 1, static_cast<unsigned long long>(event.frame),
+                i + 1 < profiler.recorded.size() ? "," : "");
+    }
+    fprintf(file, "],\n\"displayTimeUnit\":\"ms\"}\n");
+    bool const ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
+
+bool write_profile_csv(FrameProfiler const &profiler, std::string const &path) {
+    FILE *file = fopen(path.c_str(), "w");
+    if (!file) {
+        printf("Can't write trace %s\n", path.c_str());
+        return false;
+    }
+    fprintf(file, "frame,stage,start_ms,duration_ms\n");
+    for (ProfileEvent const &event : profiler.recorded) {
+        fprintf(file, "%llu,%s,%.4f,%.4f\n", static_cast<unsigned long long>(event.frame),
+                profile_stage_name(event.stage), event.start_ms, event.duration_ms);
+    }
+    bool const ok = ferror(file) == 0;
+    fclose(file);
+    return ok;
+}
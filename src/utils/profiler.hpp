@@ -0,0 +1,149 @@
+#ifndef PROFILER_HPP_
+#define PROFILER_HPP_
+
+#include "../includes/common.h"
+
+#include <chrono>
+
+// Parts of a frame timed separately
+enum ProfileStage : unsigned {
+    STAGE_FRAME = 0,
+    STAGE_INPUT,
+    STAGE_IMGUI,
+    STAGE_UPLOAD,
+    STAGE_DRAW,
+    STAGE_SWAP,
+    // Measured by GL_TIME_ELAPSED queries, a few frames late
+    STAGE_GPU_DRAW,
+    PROFILE_STAGE_COUNT,
+};
+
+// Frames kept for the rolling graphs
+constexpr size_t PROFILE_HISTORY = 240;
+
+/**
+ * @brief One timed scope, times in milliseconds since the profiler started
+ */
+struct ProfileEvent {
+    unsigned stage;
+    uint64_t frame;
+    double start_ms;
+    double duration_ms;
+};
+
+/**
+ * @brief Per-frame timings of the viewer
+ *
+ * Every stage keeps its total per frame for the last PROFILE_HISTORY frames.
+ * While recording, each timed scope is also kept as an event for exporting.
+ */
+struct FrameProfiler {
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    uint64_t frame = 0;
+    double frame_start_ms = 0.0;
+    // Totals of the frame in progress
+    double frame_totals[PROFILE_STAGE_COUNT] = {};
+    // Ring of finished frame totals, history_next is the oldest
+    float history[PROFILE_STAGE_COUNT][PROFILE_HISTORY] = {};
+    size_t history_next = 0;
+    // Frames from record_begin up to record_end are kept as events
+    uint64_t record_begin = 0;
+    uint64_t record_end = 0;
+    std::vector<ProfileEvent> recorded;
+};
+
+/**
+ * @brief Time since the profiler was made
+ *
+ * @param profiler Profiler to read
+ * @return Returns milliseconds
+ */
+double profile_now_ms(FrameProfiler const &profiler);
+
+/**
+ * @brief Starts timing a new frame
+ *
+ * @param profiler Profiler to update
+ */
+void begin_profile_frame(FrameProfiler &profiler);
+
+/**
+ * @brief Stores the frame totals in the history and moves to the next frame
+ *
+ * @param profiler Profiler to update
+ */
+void end_profile_frame(FrameProfiler &profiler);
+
+/**
+ * @brief Adds a timed scope to a stage of a frame
+ *
+ * Samples of frames already ended, like GPU timings, are added to that
+ * frame's history slot while it is still in the history.
+ *
+ * @param profiler Profiler to update
+ * @param stage ProfileStage
+ * @param frame Frame the work belongs to
+ * @param start_ms Start, from profile_now_ms
+ * @param duration_ms Duration in milliseconds
+ */
+void add_profile_sample(FrameProfiler &profiler, unsigned stage, uint64_t frame, double start_ms, double duration_ms);
+
+/**
+ * @brief Records every event of the next frames for exporting
+ *
+ * @param profiler Profiler to update
+ * @param frames Number of frames to record, previous recordings are dropped
+ */
+void start_profile_recording(FrameProfiler &profiler, size_t frames);
+
+/**
+ * @brief Average and worst total of a stage over the history
+ *
+ * @param profiler Profiler to read
+ * @param stage ProfileStage
+ * @param average Output average in milliseconds
+ * @param worst Output maximum in milliseconds
+ */
+void profile_stage_summary(FrameProfiler const &profiler, unsigned stage, float &average, float &worst);
+
+/**
+ * @brief Short name of a stage
+ *
+ * @param stage ProfileStage
+ */
+char const *profile_stage_name(unsigned stage);
+
+/**
+ * @brief Writes the recorded events as Chrome trace JSON (chrome://tracing, Perfetto)
+ *
+ * @param profiler Profiler with a recording
+ * @param path Output file
+ * @return Returns false if the file could not be written
+ */
+bool write_chrome_trace(FrameProfiler const &profiler, std::string const &path);
+
+/**
+ * @brief Writes the recorded events as CSV, one event per line
+ *
+ * @param profiler Profiler with a recording
+ * @param path Output file
+ * @return Returns false if the file could not be written
+ */
+bool write_profile_csv(FrameProfiler const &profiler, std::string const &path);
+
+/**
+ * @brief Times a scope on the CPU and adds it to the current frame
+ */
+struct ScopedProfileTimer {
+    FrameProfiler &profiler;
+    unsigned stage;
+    double start_ms;
+
+    ScopedProfileTimer(FrameProfiler &profiler, unsigned stage)
+        : profiler(profiler), stage(stage), start_ms(profile_now_ms(profiler)) {}
+    ~ScopedProfileTimer() {
+        add_profile_sample(profiler, stage, profiler.frame, start_ms, profile_now_ms(profiler) - start_ms);
+    }
+};
+
+#endif  // PROFILER_HPP_
@@ -4,10 +4,11 @@ std::string get_filename(std::string s) {
     return s.substr(s.find_last_of("/") + 1);
 }
 
-glm::mat4 compute_mvp(float const &fov, glm::vec3 const &camera_pos, glm::vec3 const &camera_center, float const &near, float const &far) {
+glm::mat4 compute_mvp(float const &fov, glm::vec3 const &camera_pos, glm::vec3 const &camera_center, float const &near, float const &far,
+                      float const aspect) {
     glm::mat4 Projection = glm::perspective(
         glm::radians(fov),
-        (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT,
+        aspect,
          near, far
     );
 
@@ -23,6 +24,14 @@ glm::mat4 compute_mvp(float const &fov, glm::vec3 const &camera_pos, glm::vec3 c
     return MVP;
 }
 
+void calculate_camera_position(glm::vec3 &camera_position, float const distance_to_center, float const yaw_angle, float const pitch_angle) {
+    auto const theta = glm::radians(pitch_angle);
+    auto const phi = glm::radians(yaw_angle);
+    camera_position.x = distance_to_center * glm::cos(phi) * glm::sin(theta);
+    camera_position.z = distance_to_center * glm::sin(phi) * glm::sin(theta);
+    camera_position.y = distance_to_center * glm::cos(theta);
+}
+
 void generate_random_colors(GLfloat colors[], size_t size) {
     for (size_t v = 0; v < size * 3; v++) {
         colors[3 * v + 0] = float(rand()) / float(RAND_MAX);
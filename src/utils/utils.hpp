@@ -33,7 +33,19 @@ std::string get_file_extension(std::string const &s);
  * @param init_pos Initial position of the camera
  * @param y Y of the translation vector
  * @param z X of the translation vector
+ * @param aspect Width over height of the viewport
  */
-glm::mat4 compute_mvp(float const &fov, glm::vec3 const &camera_pos, glm::vec3 const &camera_center, float const &near, float const &far);
+glm::mat4 compute_mvp(float const &fov, glm::vec3 const &camera_pos, glm::vec3 const &camera_center, float const &near, float const &far,
+                      float const aspect = (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT);
+
+/**
+ * @brief Places an orbiting camera around the origin
+ *
+ * @param camera_position Output position, relative to the point looked at
+ * @param distance_to_center Orbit radius
+ * @param yaw_angle Angle around the Y axis, in degrees
+ * @param pitch_angle Angle from the +Y axis, in degrees
+ */
+void calculate_camera_position(glm::vec3 &camera_position, float const distance_to_center, float const yaw_angle, float const pitch_angle);
 
 #endif  // UTILS_HPP_